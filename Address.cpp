@@ -0,0 +1,198 @@
+#include <immintrin.h>
+
+#include <cstring>
+
+#include "Address.h"
+#include "sha256_avx512.h"
+#include "simd_avx512.h"
+
+static const char *BECH32_CHARSET = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+// Value of each Base58 / Bech32 character, -1 for characters outside the alphabet.
+struct AlphabetTables {
+  int8_t base58[128];
+  int8_t bech32[128];
+  AlphabetTables() {
+    const char *base58Chars = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    memset(base58, -1, sizeof(base58));
+    memset(bech32, -1, sizeof(bech32));
+    for (int i = 0; i < 58; i++) base58[(int)base58Chars[i]] = (int8_t)i;
+    for (int i = 0; i < 32; i++) {
+      const char c = BECH32_CHARSET[i];
+      bech32[(int)c] = (int8_t)i;
+      if (c >= 'a') bech32[c - 'a' + 'A'] = (int8_t)i;
+    }
+  }
+};
+static const AlphabetTables TABLES;
+
+const char *AddressStatusText(AddressStatus status) {
+  switch (status) {
+    case ADDRESS_OK:
+      return "ok";
+    case ADDRESS_BAD_CHARACTER:
+      return "invalid character";
+    case ADDRESS_BAD_LENGTH:
+      return "invalid length";
+    case ADDRESS_BAD_CHECKSUM:
+      return "checksum mismatch";
+    case ADDRESS_UNSUPPORTED:
+      return "not a P2PKH or P2WPKH address";
+  }
+  return "unknown error";
+}
+
+AddressStatus Base58DecodeP2PKH(const char *address, size_t length, uint8_t payload[25]) {
+  if (length < 26 || length > 35) return ADDRESS_BAD_LENGTH;
+
+  // The value is accumulated in 32-bit limbs, five digits (58^5 < 2^32) per multiply pass.
+  uint32_t limbs[7] = {0};
+  size_t i = 0;
+  while (i < length) {
+    uint32_t chunk = 0, scale = 1;
+    for (int k = 0; k < 5 && i < length; k++, i++) {
+      const unsigned char c = (unsigned char)address[i];
+      const int digit = c < 128 ? TABLES.base58[c] : -1;
+      if (digit < 0) return ADDRESS_BAD_CHARACTER;
+      chunk = chunk * 58 + (uint32_t)digit;
+      scale *= 58;
+    }
+    uint64_t carry = chunk;
+    for (int j = 0; j < 7; j++) {
+      const uint64_t t = (uint64_t)limbs[j] * scale + carry;
+      limbs[j] = (uint32_t)t;
+      carry = t >> 32;
+    }
+    if (carry) return ADDRESS_BAD_LENGTH;
+  }
+  if (limbs[6] >> 8) return ADDRESS_BAD_LENGTH;
+  for (int b = 0; b < 25; b++) payload[24 - b] = (uint8_t)(limbs[b / 4] >> (8 * (b % 4)));
+
+  // Every leading '1' stands for one leading zero byte, and only those do.
+  size_t ones = 0, zeros = 0;
+  while (ones < length && address[ones] == '1') ones++;
+  while (zeros < 25 && payload[zeros] == 0) zeros++;
+  if (ones != zeros) return ADDRESS_BAD_LENGTH;
+  return payload[0] == 0x00 ? ADDRESS_OK : ADDRESS_UNSUPPORTED;
+}
+
+uint16_t Base58CheckBatch(const uint8_t *payloads[16]) {
+  // The checksum is the first four bytes of SHA-256(SHA-256(version || hash160)); both
+  // messages fit in one padded block.
+  alignas(64) uint8_t blocks[16][64];
+  alignas(64) uint8_t digests[16][32];
+  const uint8_t *in[16];
+  uint8_t *out[16];
+  memset(blocks, 0, sizeof(blocks));
+  for (int i = 0; i < 16; i++) {
+    memcpy(blocks[i], payloads[i], 21);
+    blocks[i][21] = 0x80;
+    blocks[i][63] = 21 * 8;
+    in[i] = blocks[i];
+    out[i] = digests[i];
+  }
+  sha256avx512_16B(in, out);
+
+  memset(blocks, 0, sizeof(blocks));
+  for (int i = 0; i < 16; i++) {
+    memcpy(blocks[i], digests[i], 32);
+    blocks[i][32] = 0x80;
+    blocks[i][62] = (32 * 8) >> 8;
+  }
+  sha256avx512_16B(in, out);
+
+  uint16_t valid = 0;
+  for (int i = 0; i < 16; i++) {
+    if (memcmp(digests[i], payloads[i] + 21, 4) == 0) valid |= (uint16_t)(1u << i);
+  }
+  return valid;
+}
+
+AddressStatus Bech32DecodeP2WPKH(const char *address, size_t length, uint8_t hash160[20],
+                                 uint8_t values[BECH32_P2WPKH_VALUES]) {
+  // hrp "bc" or "tb", separator, version, 32 groups of the program, 6 checksum characters.
+  // Other lengths are other witness programs (P2WSH, P2TR).
+  if (length < 3) return ADDRESS_BAD_LENGTH;
+  const char hrp[2] = {(char)(address[0] | 0x20), (char)(address[1] | 0x20)};
+  const bool knownHrp = (hrp[0] == 'b' && hrp[1] == 'c') || (hrp[0] == 't' && hrp[1] == 'b');
+  if (address[2] != '1' || !knownHrp || length != 42) return ADDRESS_UNSUPPORTED;
+
+  bool lower = false, upper = false;
+  for (size_t i = 0; i < length; i++) {
+    lower |= address[i] >= 'a' && address[i] <= 'z';
+    upper |= address[i] >= 'A' && address[i] <= 'Z';
+  }
+  if (lower && upper) return ADDRESS_BAD_CHARACTER;
+
+  values[0] = (uint8_t)(hrp[0] >> 5);
+  values[1] = (uint8_t)(hrp[1] >> 5);
+  values[2] = 0;
+  values[3] = (uint8_t)(hrp[0] & 31);
+  values[4] = (uint8_t)(hrp[1] & 31);
+  uint8_t *data = values + 5;
+  for (int i = 0; i < 39; i++) {
+    const unsigned char c = (unsigned char)address[3 + i];
+    const int value = c < 128 ? TABLES.bech32[c] : -1;
+    if (value < 0) return ADDRESS_BAD_CHARACTER;
+    data[i] = (uint8_t)value;
+  }
+  // Version 0 uses the Bech32 constant; later versions (Bech32m) do not carry a hash160.
+  if (data[0] != 0) return ADDRESS_UNSUPPORTED;
+
+  uint32_t acc = 0;
+  int bits = 0, n = 0;
+  for (int i = 1; i < 33; i++) {
+    acc = (acc << 5) | data[i];
+    bits += 5;
+    if (bits >= 8) {
+      bits -= 8;
+      hash160[n++] = (uint8_t)(acc >> bits);
+    }
+  }
+  return ADDRESS_OK;
+}
+
+uint16_t Bech32CheckBatch(const uint8_t *values[16]) {
+  static const uint32_t GEN[5] = {0x3B6A57B2, 0x26508E6D, 0x1EA119FA, 0x3D4233DD, 0x2A1462B3};
+  alignas(64) uint32_t columns[BECH32_P2WPKH_VALUES][16];
+  for (int lane = 0; lane < 16; lane++) {
+    for (int i = 0; i < BECH32_P2WPKH_VALUES; i++) columns[i][lane] = values[lane][i];
+  }
+
+  // The polymod runs in all 16 lanes at once; each of the five bits shifted out selects one
+  // generator term through a mask instead of a branch.
+  const __m512i low25 = _mm512_set1_epi32(0x1FFFFFF);
+  __m512i chk = _mm512_set1_epi32(1);
+  for (int i = 0; i < BECH32_P2WPKH_VALUES; i++) {
+    const __m512i top = srli_epi32(chk, 25);
+    chk = _mm512_xor_si512(slli_epi32(_mm512_and_si512(chk, low25), 5),
+                           _mm512_load_epi32(columns[i]));
+    for (int g = 0; g < 5; g++) {
+      const __mmask16 selected = _mm512_test_epi32_mask(top, _mm512_set1_epi32(1 << g));
+      chk = _mm512_mask_xor_epi32(chk, selected, chk, _mm512_set1_epi32(GEN[g]));
+    }
+  }
+  return (uint16_t)_mm512_cmpeq_epi32_mask(chk, _mm512_set1_epi32(1));
+}
+
+AddressStatus DecodeAddress(const std::string &address, uint8_t hash160[20]) {
+  // Single addresses are rare enough to go through the batch checks with one lane in use.
+  // P2PKH addresses always start with '1'; Bech32 ones with their hrp.
+  if (!address.empty() && address[0] != '1') {
+    uint8_t values[BECH32_P2WPKH_VALUES];
+    const AddressStatus status =
+        Bech32DecodeP2WPKH(address.data(), address.length(), hash160, values);
+    if (status != ADDRESS_OK) return status;
+    const uint8_t *batch[16];
+    for (int i = 0; i < 16; i++) batch[i] = values;
+    return (Bech32CheckBatch(batch) & 1) ? ADDRESS_OK : ADDRESS_BAD_CHECKSUM;
+  }
+  uint8_t payload[25];
+  const AddressStatus status = Base58DecodeP2PKH(address.data(), address.length(), payload);
+  if (status != ADDRESS_OK) return status;
+  const uint8_t *batch[16];
+  for (int i = 0; i < 16; i++) batch[i] = payload;
+  if (!(Base58CheckBatch(batch) & 1)) return ADDRESS_BAD_CHECKSUM;
+  memcpy(hash160, payload + 1, 20);
+  return ADDRESS_OK;
+}
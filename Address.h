@@ -0,0 +1,46 @@
+#ifndef ADDRESSH
+#define ADDRESSH
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// Decoding of P2PKH (Base58Check) and P2WPKH (Bech32) addresses into the hash160 they pay to.
+
+enum AddressStatus {
+  ADDRESS_OK,
+  ADDRESS_BAD_CHARACTER,
+  ADDRESS_BAD_LENGTH,
+  ADDRESS_BAD_CHECKSUM,
+  // A valid address of a kind that does not pay to a public key hash (P2SH, P2TR, ...).
+  ADDRESS_UNSUPPORTED
+};
+
+const char *AddressStatusText(AddressStatus status);
+
+// Decodes the Base58 digits of a P2PKH address into its 25-byte payload (version byte,
+// hash160, 4-byte checksum). The checksum is not verified; see Base58CheckBatch.
+AddressStatus Base58DecodeP2PKH(const char *address, size_t length, uint8_t payload[25]);
+
+// Verifies the checksums of 16 payloads at once with two passes of the 16-lane SHA-256
+// kernel. Returns the lanes whose checksum matches.
+uint16_t Base58CheckBatch(const uint8_t *payloads[16]);
+
+// Number of 5-bit values the Bech32 checksum of a P2WPKH address runs over: the expanded
+// two-character hrp followed by the 39 data characters.
+static const int BECH32_P2WPKH_VALUES = 5 + 39;
+
+// Decodes a witness version 0 Bech32 address with a 20-byte program into its hash160 and the
+// values its checksum covers. The checksum is not verified; see Bech32CheckBatch.
+AddressStatus Bech32DecodeP2WPKH(const char *address, size_t length, uint8_t hash160[20],
+                                 uint8_t values[BECH32_P2WPKH_VALUES]);
+
+// Verifies the checksums of 16 decoded addresses at once, one per 32-bit lane. Returns the
+// lanes whose checksum matches.
+uint16_t Bech32CheckBatch(const uint8_t *values[16]);
+
+// Decodes one address of either kind.
+AddressStatus DecodeAddress(const std::string &address, uint8_t hash160[20]);
+
+#endif
@@ -0,0 +1,134 @@
+#include <algorithm>
+
+#include "ChunkScheduler.h"
+
+bool ChunkDeque::Pop(int64_t &chunk) {
+  const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+  bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t t = top.load(std::memory_order_relaxed);
+  if (t > b) {
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return false;
+  }
+  chunk = b;
+  if (t < b) return true;
+  // Last chunk: race the thieves for it.
+  const bool won =
+      top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  bottom.store(b + 1, std::memory_order_relaxed);
+  return won;
+}
+
+bool ChunkDeque::Steal(int64_t &chunk) {
+  int64_t t = top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const int64_t b = bottom.load(std::memory_order_acquire);
+  if (t >= b) return false;
+  chunk = t;
+  return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed);
+}
+
+int64_t ChunkDeque::Size() const {
+  return std::max<int64_t>(0, bottom.load(std::memory_order_acquire) -
+                                  top.load(std::memory_order_acquire));
+}
+
+RankRange ChunkDeque::Chunk(int64_t chunk) const {
+  const __uint128_t first = start + (__uint128_t)(count - 1 - chunk) * chunkSize;
+  const __uint128_t last = std::min(end, first + chunkSize);
+  return {first, first, last};
+}
+
+void ChunkScheduler::Init(const std::vector<RankRange> &ranges, const std::vector<int> &owners,
+                          int workers, __uint128_t chunkSize) {
+  dequeCount = (int)ranges.size();
+  deques.reset(new ChunkDeque[std::max(dequeCount, 1)]);
+  workerCount = workers;
+  slots.reset(new WorkerSlot[std::max(workers, 1)]);
+  for (int i = 0; i < dequeCount; i++) {
+    ChunkDeque &deque = deques[i];
+    deque.start = ranges[i].position;
+    deque.end = ranges[i].end;
+    // Chunk numbers have to fit the 64-bit deque indices.
+    const __uint128_t length = deque.end - deque.start;
+    deque.chunkSize = std::max(chunkSize, length / ((__uint128_t)1 << 62) + 1);
+    deque.owner = owners[i];
+    deque.count = (int64_t)((length + deque.chunkSize - 1) / deque.chunkSize);
+    deque.top.store(0);
+    deque.bottom.store(deque.count);
+  }
+}
+
+bool ChunkScheduler::Next(int threadId, RankRange &chunk) {
+  WorkerSlot &slot = slots[threadId];
+  std::lock_guard<std::mutex> guard(slot.lock);
+  slot.active = false;
+
+  int64_t number;
+  for (int i = 0; i < dequeCount; i++) {
+    if (deques[i].owner == threadId && deques[i].Pop(number)) {
+      chunk = deques[i].Chunk(number);
+      slot.current = chunk;
+      slot.done.store(0, std::memory_order_relaxed);
+      slot.active = true;
+      return true;
+    }
+  }
+
+  // Steal from whichever deque has the most left; a lost race just means trying again.
+  while (true) {
+    int victim = -1;
+    int64_t most = 0;
+    for (int i = 0; i < dequeCount; i++) {
+      const int64_t size = deques[i].Size();
+      if (size > most) {
+        most = size;
+        victim = i;
+      }
+    }
+    if (victim < 0) return false;
+    if (deques[victim].Steal(number)) {
+      steals++;
+      chunk = deques[victim].Chunk(number);
+      slot.current = chunk;
+      slot.done.store(0, std::memory_order_relaxed);
+      slot.active = true;
+      return true;
+    }
+  }
+}
+
+std::vector<RankRange> ChunkScheduler::Remaining() {
+  std::vector<std::unique_lock<std::mutex>> guards;
+  for (int i = 0; i < workerCount; i++) guards.emplace_back(slots[i].lock);
+
+  std::vector<RankRange> remaining;
+  for (int i = 0; i < workerCount; i++) {
+    const RankRange &current = slots[i].current;
+    const __uint128_t position = current.start + slots[i].done.load(std::memory_order_acquire);
+    if (slots[i].active && position < current.end) {
+      remaining.push_back({position, position, current.end});
+    }
+  }
+  for (int i = 0; i < dequeCount; i++) {
+    const ChunkDeque &deque = deques[i];
+    const int64_t t = deque.top.load(), b = deque.bottom.load();
+    if (t >= b) continue;
+    const __uint128_t first = deque.Chunk(b - 1).start;
+    const __uint128_t last = deque.Chunk(t).end;
+    remaining.push_back({first, first, last});
+  }
+  std::sort(remaining.begin(), remaining.end(),
+            [](const RankRange &a, const RankRange &b) { return a.position < b.position; });
+  std::vector<RankRange> merged;
+  for (const RankRange &range : remaining) {
+    if (!merged.empty() && merged.back().end == range.position) {
+      merged.back().end = range.end;
+    } else {
+      merged.push_back(range);
+    }
+  }
+  return merged;
+}
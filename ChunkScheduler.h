@@ -0,0 +1,80 @@
+#ifndef CHUNKSCHEDULERH
+#define CHUNKSCHEDULERH
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A contiguous run of combination ranks. position is the first rank whose keys have not all
+// been checked yet.
+struct RankRange {
+  __uint128_t start;
+  __uint128_t position;
+  __uint128_t end;
+};
+
+// Chunks of one range, numbered 0..count-1 from its end; chunk c covers the ranks from
+// start + (count - 1 - c) * chunkSize on. Only the numbers are queued, so no buffer is needed:
+// the owner pops from the bottom, walking the range in rank order, and other threads steal
+// from the top, its far end (Chase-Lev).
+struct alignas(64) ChunkDeque {
+  __uint128_t start = 0;
+  __uint128_t end = 0;
+  __uint128_t chunkSize = 1;
+  int64_t count = 0;
+  int owner = 0;
+  std::atomic<int64_t> top{0};
+  std::atomic<int64_t> bottom{0};
+
+  bool Pop(int64_t &chunk);
+  // Fails when the deque is empty or another thread took the chunk first.
+  bool Steal(int64_t &chunk);
+  int64_t Size() const;
+  RankRange Chunk(int64_t chunk) const;
+};
+
+// Hands out fixed-size chunks of rank ranges to worker threads. Every thread owns the deques
+// of its share of the ranges and steals from the fullest other deque once those are empty, so
+// fast threads keep working while slow ones finish their share.
+class ChunkScheduler {
+ public:
+  // ranges[i] goes to thread owners[i]; chunks hold chunkSize ranks.
+  void Init(const std::vector<RankRange> &ranges, const std::vector<int> &owners, int workers,
+            __uint128_t chunkSize);
+
+  // Gives threadId its next chunk. Returns false once there is nothing left to take.
+  bool Next(int threadId, RankRange &chunk);
+  // Records that every rank of threadId's current chunk below position has been checked. Only
+  // threadId calls this; it is a single store, so the search loop takes no lock.
+  void Advance(int threadId, __uint128_t position) {
+    WorkerSlot &slot = slots[threadId];
+    slot.done.store((uint64_t)(position - slot.current.start), std::memory_order_release);
+  }
+  // The untaken chunks of every deque plus the unchecked part of every chunk in progress,
+  // sorted, with adjacent ranges merged.
+  std::vector<RankRange> Remaining();
+
+  uint64_t Steals() const { return steals.load(); }
+
+ private:
+  // What a thread is working on: ranks current.start + done onward are left in its chunk. A
+  // chunk changes hands only under its thread's lock, so holding all of them freezes the
+  // deques for Remaining(). Chunks are far smaller than 2^64 ranks.
+  struct alignas(64) WorkerSlot {
+    std::mutex lock;
+    bool active = false;
+    RankRange current = {0, 0, 0};
+    std::atomic<uint64_t> done{0};
+  };
+
+  std::unique_ptr<ChunkDeque[]> deques;
+  int dequeCount = 0;
+  std::unique_ptr<WorkerSlot[]> slots;
+  int workerCount = 0;
+  std::atomic<uint64_t> steals{0};
+};
+
+#endif
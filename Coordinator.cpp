@@ -0,0 +1,496 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Coordinator.h"
+
+// A line longer than this is not part of the protocol; the connection is dropped.
+static const size_t MAX_LINE = 4096;
+// How long a worker waits before asking again when everything is out on lease.
+static const int WAIT_RETRY_MS = 1000;
+
+static std::string rankText(__uint128_t value) {
+  if (value == 0) return "0";
+  std::string text;
+  while (value > 0) {
+    text += (char)('0' + (int)(value % 10));
+    value /= 10;
+  }
+  std::reverse(text.begin(), text.end());
+  return text;
+}
+
+static bool parseRank(const std::string &text, __uint128_t &value) {
+  if (text.empty() || text.length() > 39) return false;
+  value = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') return false;
+    value = value * 10 + (c - '0');
+  }
+  return true;
+}
+
+// Splits "PORT", "HOST:PORT" or "[IPV6]:PORT" into its parts. An IPv6 host without brackets
+// cannot be told from its port, so it is refused.
+static bool splitHostPort(const std::string &address, std::string &host, std::string &port,
+                          std::string &error) {
+  const size_t colon = address.rfind(':');
+  if (colon == std::string::npos) {
+    host = "127.0.0.1";
+    port = address;
+    return true;
+  }
+  host = address.substr(0, colon);
+  port = address.substr(colon + 1);
+  if (host.length() > 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.length() - 2);
+  } else if (host.find_first_of(":[]") != std::string::npos) {
+    error = "bad address " + address + "; write an IPv6 host in brackets, as in [::1]:" + port;
+    return false;
+  }
+  return true;
+}
+
+#ifdef _WIN32
+
+static const char *UNSUPPORTED = "coordinator sockets are not supported on Windows";
+
+static int openListener(const std::string &, std::string &, std::string &error) {
+  error = UNSUPPORTED;
+  return -1;
+}
+static int openConnection(const std::string &, std::string &error) {
+  error = UNSUPPORTED;
+  return -1;
+}
+static int acceptConnection(int, std::string &) { return -1; }
+static int waitReadable(const std::vector<int> &, std::vector<bool> &, int) { return -1; }
+static long receive(int, char *, size_t) { return -1; }
+static bool sendAll(int, const std::string &) { return false; }
+static void closeSocket(int) {}
+static void removeSocketFile(const std::string &) {}
+
+#else
+
+static int openListener(const std::string &address, std::string &unixPath, std::string &error) {
+  int fd;
+  if (address.compare(0, 5, "unix:") == 0) {
+    unixPath = address.substr(5);
+    sockaddr_un local;
+    memset(&local, 0, sizeof(local));
+    if (unixPath.empty() || unixPath.length() >= sizeof(local.sun_path)) {
+      error = "bad socket path " + unixPath;
+      return -1;
+    }
+    local.sun_family = AF_UNIX;
+    strcpy(local.sun_path, unixPath.c_str());
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(unixPath.c_str());
+    if (fd < 0 || bind(fd, (sockaddr *)&local, sizeof(local)) != 0) {
+      error = "cannot listen on " + address + ": " + strerror(errno);
+      if (fd >= 0) close(fd);
+      return -1;
+    }
+  } else {
+    std::string host, port;
+    if (!splitHostPort(address, host, port, error)) return -1;
+    addrinfo hints, *found;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+      error = "cannot resolve " + address;
+      return -1;
+    }
+    fd = ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    const int reuse = 1;
+    if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (fd < 0 || bind(fd, found->ai_addr, found->ai_addrlen) != 0) {
+      error = "cannot listen on " + address + ": " + strerror(errno);
+      if (fd >= 0) close(fd);
+      freeaddrinfo(found);
+      return -1;
+    }
+    freeaddrinfo(found);
+  }
+  if (listen(fd, 64) != 0) {
+    error = "cannot listen on " + address + ": " + strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int openConnection(const std::string &address, std::string &error) {
+  int fd;
+  if (address.compare(0, 5, "unix:") == 0) {
+    const std::string path = address.substr(5);
+    sockaddr_un remote;
+    memset(&remote, 0, sizeof(remote));
+    if (path.empty() || path.length() >= sizeof(remote.sun_path)) {
+      error = "bad socket path " + path;
+      return -1;
+    }
+    remote.sun_family = AF_UNIX;
+    strcpy(remote.sun_path, path.c_str());
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&remote, sizeof(remote)) != 0) {
+      error = "cannot connect to " + address + ": " + strerror(errno);
+      if (fd >= 0) close(fd);
+      return -1;
+    }
+    return fd;
+  }
+  std::string host, port;
+  if (!splitHostPort(address, host, port, error)) return -1;
+  addrinfo hints, *found;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+    error = "cannot resolve " + address;
+    return -1;
+  }
+  fd = ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+  if (fd < 0 || connect(fd, found->ai_addr, found->ai_addrlen) != 0) {
+    error = "cannot connect to " + address + ": " + strerror(errno);
+    if (fd >= 0) close(fd);
+    freeaddrinfo(found);
+    return -1;
+  }
+  freeaddrinfo(found);
+  // Requests are single short lines; do not hold them back.
+  const int noDelay = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  return fd;
+}
+
+static int acceptConnection(int listener, std::string &peer) {
+  sockaddr_storage remote;
+  socklen_t length = sizeof(remote);
+  const int fd = accept(listener, (sockaddr *)&remote, &length);
+  if (fd < 0) return -1;
+  char host[NI_MAXHOST], port[NI_MAXSERV];
+  peer.clear();
+  if (remote.ss_family != AF_UNIX &&
+      getnameinfo((sockaddr *)&remote, length, host, sizeof(host), port, sizeof(port),
+                  NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+    peer = std::string(host) + ":" + port;
+    const int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  }
+  return fd;
+}
+
+// Waits up to timeoutMs for any of sockets to become readable (or hung up).
+static int waitReadable(const std::vector<int> &sockets, std::vector<bool> &readable,
+                        int timeoutMs) {
+  std::vector<pollfd> fds(sockets.size());
+  for (size_t i = 0; i < sockets.size(); i++) {
+    fds[i].fd = sockets[i];
+    fds[i].events = POLLIN;
+    fds[i].revents = 0;
+  }
+  const int ready = poll(fds.data(), fds.size(), timeoutMs);
+  readable.assign(sockets.size(), false);
+  for (size_t i = 0; ready > 0 && i < sockets.size(); i++) {
+    readable[i] = (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+  }
+  return ready;
+}
+
+static long receive(int fd, char *buffer, size_t size) { return recv(fd, buffer, size, 0); }
+
+static bool sendAll(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    sent += (size_t)n;
+  }
+  return true;
+}
+
+static void closeSocket(int fd) { close(fd); }
+static void removeSocketFile(const std::string &path) { unlink(path.c_str()); }
+
+#endif
+
+// Moves the complete lines at the front of input to lines. Returns false if a line is too long.
+static bool takeLines(std::string &input, std::vector<std::string> &lines) {
+  size_t begin = 0, newline;
+  while ((newline = input.find('\n', begin)) != std::string::npos) {
+    size_t end = newline;
+    if (end > begin && input[end - 1] == '\r') end--;
+    lines.push_back(input.substr(begin, end - begin));
+    begin = newline + 1;
+  }
+  input.erase(0, begin);
+  return input.size() <= MAX_LINE;
+}
+
+Coordinator::Coordinator(const std::string &config, const std::vector<RankRange> &ranges,
+                         int leaseTimeout, bool stopOnHit)
+    : config(config), leaseTimeout(leaseTimeout), stopOnHit(stopOnHit) {
+  for (const RankRange &range : ranges) {
+    if (range.position < range.end) {
+      pending.push_back({range.position, range.position, range.end});
+    }
+  }
+}
+
+Coordinator::~Coordinator() {
+  for (const Connection &connection : connections) closeSocket(connection.socket);
+  if (listener >= 0) closeSocket(listener);
+  if (!unixPath.empty()) removeSocketFile(unixPath);
+}
+
+bool Coordinator::Listen(const std::string &address, std::string &error) {
+  listener = openListener(address, unixPath, error);
+  return listener >= 0;
+}
+
+bool Coordinator::Step(int timeoutMs) {
+  if (stopped || (pending.empty() && leases.empty())) return false;
+
+  std::vector<int> sockets = {listener};
+  for (const Connection &connection : connections) sockets.push_back(connection.socket);
+  std::vector<bool> readable;
+  if (waitReadable(sockets, readable, timeoutMs) > 0) {
+    // Connections are visited from the back so dropping one leaves the rest in place.
+    for (size_t i = connections.size(); i-- > 0;) {
+      if (!readable[i + 1]) continue;
+      char buffer[4096];
+      const long n = receive(connections[i].socket, buffer, sizeof(buffer));
+      if (n <= 0) {
+        dropConnection(i);
+        continue;
+      }
+      connections[i].input.append(buffer, (size_t)n);
+      std::vector<std::string> lines;
+      const bool ok = takeLines(connections[i].input, lines);
+      for (const std::string &line : lines) handleLine(connections[i], line);
+      if (!ok) dropConnection(i);
+    }
+    if (readable[0]) {
+      std::string peer;
+      const int socket = acceptConnection(listener, peer);
+      if (socket >= 0) {
+        // Unix-domain peers have no address to tell them apart.
+        acceptedWorkers++;
+        if (peer.empty()) peer = "worker " + std::to_string(acceptedWorkers);
+        connections.push_back({socket, peer, "", false});
+      }
+    }
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  for (auto it = leases.begin(); it != leases.end();) {
+    if (it->second.expires <= now) {
+      requeue(it->second.range);
+      it = leases.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return !stopped && !(pending.empty() && leases.empty());
+}
+
+void Coordinator::handleLine(Connection &connection, const std::string &line) {
+  std::istringstream fields(line);
+  std::string kind;
+  fields >> kind;
+  if (!connection.greeted) {
+    std::string theirs;
+    std::getline(fields >> std::ws, theirs);
+    if (kind != "HELLO") {
+      send(connection.socket, "ERROR expected HELLO");
+    } else if (theirs != config) {
+      send(connection.socket, "ERROR coordinator searches " + config);
+    } else {
+      connection.greeted = true;
+      send(connection.socket, "OK " + std::to_string(leaseTimeout));
+    }
+    return;
+  }
+
+  const auto expires = std::chrono::steady_clock::now() + std::chrono::seconds(leaseTimeout);
+  std::string first, second;
+  fields >> first >> second;
+  __uint128_t value;
+  if (kind == "LEASE") {
+    if (stopped) {
+      send(connection.socket, "STOP");
+    } else if (!pending.empty()) {
+      __uint128_t size = 0;
+      if (!parseRank(first, size) || size == 0) size = 1;
+      RankRange &next = pending.front();
+      const __uint128_t end = std::min(next.end, next.position + size);
+      const uint64_t id = nextLease++;
+      leases[id] = {connection.socket, {next.position, next.position, end}, expires};
+      send(connection.socket, "LEASE " + std::to_string(id) + " " + rankText(next.position) +
+                                  " " + rankText(end));
+      next.position = end;
+      if (next.position == next.end) pending.pop_front();
+    } else {
+      send(connection.socket, leases.empty() ? "DONE" : "WAIT");
+    }
+  } else if (kind == "PROGRESS" || kind == "COMPLETE") {
+    auto it = leases.find(strtoull(first.c_str(), nullptr, 10));
+    // Reports on a lease that expired and went to someone else are ignored.
+    if (it == leases.end() || it->second.socket != connection.socket) return;
+    if (kind == "COMPLETE") {
+      leases.erase(it);
+    } else if (parseRank(second, value) && value >= it->second.range.position &&
+               value <= it->second.range.end) {
+      it->second.range.position = value;
+      it->second.expires = expires;
+    }
+  } else if (kind == "HIT") {
+    hits.push_back(connection.peer + ": " + line.substr(std::min(line.size(), (size_t)4)));
+    if (stopOnHit) stopAll();
+  }
+}
+
+void Coordinator::dropConnection(size_t index) {
+  const int socket = connections[index].socket;
+  // A worker that went away will not finish its leases.
+  for (auto it = leases.begin(); it != leases.end();) {
+    if (it->second.socket == socket) {
+      requeue(it->second.range);
+      it = leases.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  closeSocket(socket);
+  connections.erase(connections.begin() + index);
+}
+
+void Coordinator::requeue(const RankRange &range) {
+  if (range.position < range.end) pending.push_front({range.position, range.position, range.end});
+}
+
+void Coordinator::send(int socket, const std::string &line) { sendAll(socket, line + "\n"); }
+
+void Coordinator::stopAll() {
+  stopped = true;
+  for (const Connection &connection : connections) send(connection.socket, "STOP");
+}
+
+std::vector<RankRange> Coordinator::Remaining() const {
+  std::vector<RankRange> remaining(pending.begin(), pending.end());
+  for (const auto &lease : leases) {
+    const RankRange &range = lease.second.range;
+    if (range.position < range.end) {
+      remaining.push_back({range.position, range.position, range.end});
+    }
+  }
+  std::sort(remaining.begin(), remaining.end(),
+            [](const RankRange &a, const RankRange &b) { return a.position < b.position; });
+  return remaining;
+}
+
+CoordinatorClient::~CoordinatorClient() {
+  if (socket >= 0) closeSocket(socket);
+}
+
+bool CoordinatorClient::Connect(const std::string &address, const std::string &config,
+                                std::string &error) {
+  socket = openConnection(address, error);
+  if (socket < 0) return false;
+  send("HELLO " + config);
+  std::string reply;
+  if (!readLine(reply, -1)) {
+    error = "coordinator at " + address + " closed the connection";
+    return false;
+  }
+  if (reply.compare(0, 3, "OK ") != 0) {
+    error = reply.compare(0, 6, "ERROR ") == 0 ? reply.substr(6) : "unexpected reply " + reply;
+    return false;
+  }
+  leaseTimeout = atoi(reply.c_str() + 3);
+  return true;
+}
+
+bool CoordinatorClient::Lease(__uint128_t maxCombinations, uint64_t &id, RankRange &range) {
+  while (!stopped) {
+    send("LEASE " + rankText(maxCombinations));
+    std::string reply;
+    if (!readLine(reply, -1)) return false;
+    std::istringstream fields(reply);
+    std::string kind, number, start, end;
+    fields >> kind >> number >> start >> end;
+    if (kind == "LEASE" && parseRank(start, range.start) && parseRank(end, range.end)) {
+      id = strtoull(number.c_str(), nullptr, 10);
+      range.position = range.start;
+      return true;
+    }
+    if (kind != "WAIT") break;
+    // Everything is out on lease; one may still come back.
+    while (readLine(reply, WAIT_RETRY_MS)) {
+    }
+  }
+  return false;
+}
+
+void CoordinatorClient::Progress(uint64_t id, __uint128_t position) {
+  send("PROGRESS " + std::to_string(id) + " " + rankText(position));
+}
+
+void CoordinatorClient::Complete(uint64_t id) { send("COMPLETE " + std::to_string(id)); }
+
+void CoordinatorClient::Hit(const std::string &text) { send("HIT " + text); }
+
+bool CoordinatorClient::Stopped() {
+  std::string line;
+  while (!stopped && readLine(line, 0)) {
+  }
+  return stopped;
+}
+
+// Returns the next reply, or false on timeout or once the search is over. A STOP is taken in
+// wherever it arrives.
+bool CoordinatorClient::readLine(std::string &line, int timeoutMs) {
+  while (!stopped) {
+    const size_t newline = input.find('\n');
+    if (newline != std::string::npos) {
+      line = input.substr(0, newline);
+      input.erase(0, newline + 1);
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line == "STOP") {
+        stopped = true;
+        stopReceived = true;
+        return false;
+      }
+      return true;
+    }
+    std::vector<bool> readable;
+    if (waitReadable({socket}, readable, timeoutMs) <= 0) return false;
+    char buffer[4096];
+    const long n = receive(socket, buffer, sizeof(buffer));
+    if (n <= 0 || input.size() > MAX_LINE) {
+      stopped = true;
+      return false;
+    }
+    input.append(buffer, (size_t)n);
+  }
+  return false;
+}
+
+void CoordinatorClient::send(const std::string &line) {
+  if (!stopped && !sendAll(socket, line + "\n")) stopped = true;
+}
@@ -0,0 +1,115 @@
+#ifndef COORDINATORH
+#define COORDINATORH
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ChunkScheduler.h"
+
+// Shares one search between mutagen processes: a coordinator leases rank ranges to workers
+// over a stream socket and takes them back when a worker stops reporting.
+//
+// The protocol is line based. A worker opens with "HELLO <config>" and is answered with
+// "OK <lease timeout>", or "ERROR <reason>" if it searches a different configuration. It asks
+// for work with "LEASE <max combinations>", answered by "LEASE <id> <start> <end>", "WAIT"
+// while every range is out on lease, or "DONE". While searching it sends "PROGRESS <id>
+// <position>" (every rank below position checked), which also renews the lease, and
+// "COMPLETE <id>" once the range is done. "HIT <text>" reports a hit. The coordinator sends
+// "STOP" at any time to end the search everywhere.
+//
+// Addresses are "unix:PATH" for a Unix-domain socket, or "PORT", "HOST:PORT" or
+// "[IPV6]:PORT" for TCP; HOST defaults to the loopback address.
+
+class Coordinator {
+ public:
+  // Leases out ranges to workers searching config. A lease not renewed for leaseTimeout
+  // seconds goes back to the pool; so does every lease of a worker that disconnects.
+  Coordinator(const std::string &config, const std::vector<RankRange> &ranges, int leaseTimeout,
+              bool stopOnHit);
+  ~Coordinator();
+
+  bool Listen(const std::string &address, std::string &error);
+
+  // Serves requests for up to timeoutMs. Returns false once every range has been searched or
+  // a hit has stopped the search.
+  bool Step(int timeoutMs);
+
+  // Ranges not searched yet, leased ones from their last reported position on.
+  std::vector<RankRange> Remaining() const;
+  // Hits reported so far, as "peer: text".
+  const std::vector<std::string> &Hits() const { return hits; }
+  int Workers() const { return (int)connections.size(); }
+  int Leases() const { return (int)leases.size(); }
+
+ private:
+  struct Connection {
+    int socket;
+    std::string peer;
+    std::string input;
+    bool greeted;
+  };
+  struct Lease {
+    int socket;
+    RankRange range;
+    std::chrono::steady_clock::time_point expires;
+  };
+
+  void handleLine(Connection &connection, const std::string &line);
+  void dropConnection(size_t index);
+  // Puts the unsearched rest of a lease back at the front of the pool.
+  void requeue(const RankRange &range);
+  void send(int socket, const std::string &line);
+  void stopAll();
+
+  std::string config;
+  int leaseTimeout;
+  bool stopOnHit;
+  int listener = -1;
+  std::string unixPath;
+  std::deque<RankRange> pending;
+  std::map<uint64_t, Lease> leases;
+  uint64_t nextLease = 1;
+  std::vector<Connection> connections;
+  int acceptedWorkers = 0;
+  std::vector<std::string> hits;
+  bool stopped = false;
+};
+
+class CoordinatorClient {
+ public:
+  ~CoordinatorClient();
+
+  bool Connect(const std::string &address, const std::string &config, std::string &error);
+  bool Connected() const { return socket >= 0; }
+  int LeaseTimeout() const { return leaseTimeout; }
+
+  // Waits for a lease of at most maxCombinations ranks. Returns false when the search is over,
+  // because everything has been searched, a stop was broadcast or the coordinator went away.
+  bool Lease(__uint128_t maxCombinations, uint64_t &id, RankRange &range);
+  void Progress(uint64_t id, __uint128_t position);
+  void Complete(uint64_t id);
+  void Hit(const std::string &text);
+
+  // Reads what the coordinator sent without waiting. True once it has stopped the search or
+  // closed the connection.
+  bool Stopped();
+  // True if the coordinator stopped the search, rather than just going away.
+  bool StopReceived() const { return stopReceived; }
+
+ private:
+  bool readLine(std::string &line, int timeoutMs);
+  void send(const std::string &line);
+
+  int socket = -1;
+  std::string input;
+  int leaseTimeout = 0;
+  bool stopped = false;
+  bool stopReceived = false;
+};
+
+#endif
@@ -561,7 +561,6 @@ void Int::ModMulK1(Int *a, Int *b) {
 #endif
 
   unsigned char carry1 = 0;
-  unsigned char carry2 = 0;
 
   // 256*256 multiplier
   imm_umul(a->bits64, b->bits64[0], r512);
@@ -596,9 +595,9 @@ void Int::ModMulK1(Int *a, Int *b) {
   // Reduce from 320 to 256
   al = _umul128(t[4] + carry1, 0x1000003D1ULL, &ah);
   carry1 = _addcarry_u64(0, r512[0], al, bits64 + 0);
-  carry2 = _addcarry_u64(0, r512[1], ah, bits64 + 1);
+  carry1 = _addcarry_u64(carry1, r512[1], ah, bits64 + 1);
   carry1 = _addcarry_u64(carry1, r512[2], 0ULL, bits64 + 2);
-  carry2 = _addcarry_u64(carry2, r512[3], 0ULL, bits64 + 3);
+  carry1 = _addcarry_u64(carry1, r512[3], 0ULL, bits64 + 3);
 
   bits64[4] = 0;
 #if BISIZE == 512
@@ -619,7 +618,6 @@ void Int::ModMulK1(Int *a) {
 #endif
 
   unsigned char carry1 = 0;
-  unsigned char carry2 = 0;
 
   imm_umul(a->bits64, bits64[0], r512);
   imm_umul(a->bits64, bits64[1], t);
@@ -651,9 +649,9 @@ void Int::ModMulK1(Int *a) {
 
   al = _umul128(t[4] + carry1, 0x1000003D1ULL, &ah);
   carry1 = _addcarry_u64(0, r512[0], al, bits64 + 0);
-  carry2 = _addcarry_u64(0, r512[1], ah, bits64 + 1);
+  carry1 = _addcarry_u64(carry1, r512[1], ah, bits64 + 1);
   carry1 = _addcarry_u64(carry1, r512[2], 0, bits64 + 2);
-  carry2 = _addcarry_u64(carry2, r512[3], 0, bits64 + 3);
+  carry1 = _addcarry_u64(carry1, r512[3], 0, bits64 + 3);
   bits64[4] = 0;
 #if BISIZE == 512
   bits64[5] = 0;
@@ -675,7 +673,6 @@ void Int::ModSquareK1(Int *a) {
 #endif
 
   unsigned char carry1 = 0;
-  unsigned char carry2 = 0;
 
   r512[0] = _umul128(a->bits64[0], a->bits64[0], &t[1]);
 
@@ -755,9 +752,9 @@ void Int::ModSquareK1(Int *a) {
 
   u10 = _umul128(t[4] + carry1, 0x1000003D1ULL, &u11);
   carry1 = _addcarry_u64(0, r512[0], u10, bits64 + 0);
-  carry2 = _addcarry_u64(0, r512[1], u11, bits64 + 1);
+  carry1 = _addcarry_u64(carry1, r512[1], u11, bits64 + 1);
   carry1 = _addcarry_u64(carry1, r512[2], 0, bits64 + 2);
-  carry2 = _addcarry_u64(carry2, r512[3], 0, bits64 + 3);
+  carry1 = _addcarry_u64(carry1, r512[3], 0, bits64 + 3);
   bits64[4] = 0;
 #if BISIZE == 512
   bits64[5] = 0;
@@ -232,7 +232,7 @@ Point Secp256K1::DoubleDirect(Point &p) {
   return r;
 }
 
-Point Secp256K1::ComputePublicKey(Int *privKey) {
+Point Secp256K1::ComputePublicKey(Int *privKey, bool reduce) {
   int i = 0;
   uint8_t b;
   Point Q;
@@ -253,7 +253,7 @@ Point Secp256K1::ComputePublicKey(Int *privKey) {
     if (b) Q = AddAffine(Q, GTable[256 * i + (b - 1)].x, GTable[256 * i + (b - 1)].y);
   }
 
-  Q.Reduce();
+  if (reduce) Q.Reduce();
   return Q;
 }
 
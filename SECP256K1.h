@@ -16,7 +16,7 @@ class Secp256K1 {
   Secp256K1();
   ~Secp256K1();
   void Init();
-  Point ComputePublicKey(Int *privKey);
+  Point ComputePublicKey(Int *privKey, bool reduce = true);
   Point NextKey(Point &key);
   void Check();
   bool EC(Point &p);
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "Address.h"
+#include "TargetFile.h"
+#include "TargetSet.h"
+
+// Files below this size per thread are not worth splitting further.
+static const uint64_t MIN_CHUNK_BYTES = 1 << 20;
+static const size_t READ_BLOCK = 1 << 20;
+// Longest token reported back in an error message.
+static const size_t MAX_TOKEN_ECHO = 64;
+
+namespace {
+
+struct Chunk {
+  TargetList list;
+  uint64_t lines = 0;
+  // First malformed line, counted from the start of the chunk; 0 if there is none.
+  uint64_t errorLine = 0;
+  std::string errorText;
+
+  // P2PKH payloads waiting for the batched checksum check, with their target and line. The
+  // hash160 of a target is filled in once its checksum is known to be good.
+  uint8_t base58Pending[16][25];
+  size_t base58Target[16];
+  uint64_t base58Line[16];
+  int base58Count = 0;
+  // Same for P2WPKH addresses; their hash160 is stored right away.
+  uint8_t bech32Pending[16][BECH32_P2WPKH_VALUES];
+  uint64_t bech32Line[16];
+  int bech32Count = 0;
+
+  void Fail(uint64_t line, const std::string &text) {
+    if (errorLine == 0 || line < errorLine) {
+      errorLine = line;
+      errorText = text;
+    }
+  }
+
+  // Unused lanes of a partial batch repeat the first entry.
+  void FlushBase58() {
+    if (base58Count == 0) return;
+    const uint8_t *batch[16];
+    for (int i = 0; i < 16; i++) batch[i] = base58Pending[i < base58Count ? i : 0];
+    const uint16_t valid = Base58CheckBatch(batch);
+    for (int i = 0; i < base58Count; i++) {
+      if ((valid >> i) & 1) {
+        memcpy(&list.hashes[base58Target[i] * 20], base58Pending[i] + 1, 20);
+      } else {
+        Fail(base58Line[i], badChecksum());
+      }
+    }
+    base58Count = 0;
+  }
+
+  void FlushBech32() {
+    if (bech32Count == 0) return;
+    const uint8_t *batch[16];
+    for (int i = 0; i < 16; i++) batch[i] = bech32Pending[i < bech32Count ? i : 0];
+    const uint16_t valid = Bech32CheckBatch(batch);
+    for (int i = 0; i < bech32Count; i++) {
+      if (!((valid >> i) & 1)) Fail(bech32Line[i], badChecksum());
+    }
+    bech32Count = 0;
+  }
+
+  static std::string badChecksum() {
+    return std::string("bad address (") + AddressStatusText(ADDRESS_BAD_CHECKSUM) + ")";
+  }
+};
+
+static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static std::string badToken(const char *what, const char *token, size_t length) {
+  return std::string(what) + ": " + std::string(token, std::min(length, MAX_TOKEN_ECHO));
+}
+
+// Parses one line (without its newline) into chunk. Returns false if the line is malformed.
+static bool parseLine(const char *line, size_t length, uint64_t lineNumber, bool withLabels,
+                      Chunk &chunk) {
+  const char *comment = (const char *)memchr(line, '#', length);
+  size_t end = comment ? (size_t)(comment - line) : length;
+  while (end > 0 && isBlank(line[end - 1])) end--;
+  size_t begin = 0;
+  while (begin < end && isBlank(line[begin])) begin++;
+  if (begin == end) return true;
+  size_t tokenEnd = begin;
+  while (tokenEnd < end && !isBlank(line[tokenEnd])) tokenEnd++;
+  const char *token = line + begin;
+  const size_t tokenLength = tokenEnd - begin;
+
+  const size_t target = chunk.list.hashes.size() / 20;
+  uint8_t hash160[20];
+  AddressStatus status = ADDRESS_OK;
+  if (tokenLength == 40) {
+    if (!ParseHash160(token, tokenLength, hash160)) {
+      chunk.Fail(lineNumber, badToken("not a hash160", token, tokenLength));
+      return false;
+    }
+  } else if (token[0] == '1') {
+    status = Base58DecodeP2PKH(token, tokenLength, chunk.base58Pending[chunk.base58Count]);
+    if (status == ADDRESS_OK) {
+      memset(hash160, 0, sizeof(hash160));
+      chunk.base58Target[chunk.base58Count] = target;
+      chunk.base58Line[chunk.base58Count] = lineNumber;
+      chunk.base58Count++;
+    }
+  } else {
+    status = Bech32DecodeP2WPKH(token, tokenLength, hash160,
+                                chunk.bech32Pending[chunk.bech32Count]);
+    if (status == ADDRESS_OK) chunk.bech32Line[chunk.bech32Count++] = lineNumber;
+  }
+  if (status != ADDRESS_OK) {
+    chunk.Fail(lineNumber, badToken((std::string("bad address (") + AddressStatusText(status) +
+                                     ")").c_str(),
+                                    token, tokenLength));
+    return false;
+  }
+
+  chunk.list.hashes.insert(chunk.list.hashes.end(), hash160, hash160 + 20);
+  if (withLabels) {
+    while (tokenEnd < end && isBlank(line[tokenEnd])) tokenEnd++;
+    if (tokenEnd < end) {
+      chunk.list.labels.emplace_back(line + tokenEnd, end - tokenEnd);
+    } else {
+      chunk.list.labels.emplace_back(token, tokenLength);
+    }
+  }
+  if (chunk.base58Count == 16) chunk.FlushBase58();
+  if (chunk.bech32Count == 16) chunk.FlushBech32();
+  return true;
+}
+
+// Parses the lines that start in [begin, end) of the file. The file is read in blocks and
+// split with memchr; a line is parsed in place once its newline (or the end of file) is seen.
+static void loadChunk(const std::string &path, uint64_t begin, uint64_t end, bool withLabels,
+                      Chunk &chunk) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    chunk.Fail(1, "cannot open " + path);
+    return;
+  }
+  // A line that starts in the previous chunk belongs to it, so reading starts one byte early
+  // and skips through the first newline unless that byte is one.
+  uint64_t pos = begin > 0 ? begin - 1 : 0;
+  in.seekg((std::streamoff)pos);
+  bool skipping = begin > 0;
+
+  std::string data;
+  std::vector<char> block(READ_BLOCK);
+  size_t at = 0;
+  bool eof = false;
+  while (pos < end || skipping) {
+    const char *lineStart = data.data() + at;
+    const char *newline = (const char *)memchr(lineStart, '\n', data.size() - at);
+    size_t lineLength;
+    if (newline) {
+      lineLength = (size_t)(newline - lineStart);
+    } else if (!eof) {
+      data.erase(0, at);
+      at = 0;
+      in.read(block.data(), READ_BLOCK);
+      const size_t got = (size_t)in.gcount();
+      eof = got < READ_BLOCK;
+      data.append(block.data(), got);
+      continue;
+    } else if (at < data.size()) {
+      lineLength = data.size() - at;
+    } else {
+      break;
+    }
+
+    at += lineLength + 1;
+    pos += lineLength + 1;
+    if (skipping) {
+      skipping = false;
+      continue;
+    }
+    chunk.lines++;
+    if (!parseLine(lineStart, lineLength, chunk.lines, withLabels, chunk)) break;
+  }
+  chunk.FlushBase58();
+  chunk.FlushBech32();
+}
+
+}  // namespace
+
+bool LoadTargetsFile(const std::string &path, int threads, bool withLabels, TargetList &list,
+                     std::string &error) {
+  std::ifstream probe(path, std::ios::binary | std::ios::ate);
+  if (!probe) {
+    error = "cannot open targets file " + path;
+    return false;
+  }
+  const uint64_t size = (uint64_t)probe.tellg();
+  probe.close();
+
+  const int chunks = (int)std::max<uint64_t>(
+      1, std::min<uint64_t>((uint64_t)std::max(threads, 1), size / MIN_CHUNK_BYTES));
+  std::vector<Chunk> parts(chunks);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < chunks; i++) {
+    workers.emplace_back(loadChunk, std::cref(path), size * i / chunks, size * (i + 1) / chunks,
+                         withLabels, std::ref(parts[i]));
+  }
+  for (std::thread &t : workers) t.join();
+
+  uint64_t linesBefore = 0;
+  for (const Chunk &part : parts) {
+    if (part.errorLine) {
+      error = path + ":" + std::to_string(linesBefore + part.errorLine) + ": " + part.errorText;
+      return false;
+    }
+    linesBefore += part.lines;
+  }
+  for (Chunk &part : parts) {
+    list.hashes.insert(list.hashes.end(), part.list.hashes.begin(), part.list.hashes.end());
+    if (withLabels) {
+      for (std::string &label : part.list.labels) list.labels.push_back(std::move(label));
+    }
+    part.list = TargetList();
+  }
+  return true;
+}
@@ -0,0 +1,23 @@
+#ifndef TARGETFILEH
+#define TARGETFILEH
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Targets read from a file, in file order.
+struct TargetList {
+  std::vector<uint8_t> hashes;      // 20 bytes per target
+  std::vector<std::string> labels;  // one per target, empty unless labels were requested
+};
+
+// Reads a targets file: one target per line, given as 40 hex digits, a P2PKH (Base58Check)
+// or a P2WPKH (Bech32) address, optionally followed by a label ('#' starts a comment). A
+// missing label defaults to the target as written. The file is split at line boundaries into
+// one chunk per thread; address checksums are verified 16 at a time. Appends to list; on a
+// malformed line, error names the first one in the file.
+bool LoadTargetsFile(const std::string &path, int threads, bool withLabels, TargetList &list,
+                     std::string &error);
+
+#endif
@@ -0,0 +1,302 @@
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TargetIndex.h"
+#include "simd_avx512.h"
+#include "transpose_avx512.h"
+
+static const char INDEX_MAGIC[8] = {'M', 'U', 'T', 'A', 'G', 'I', 'D', 'X'};
+static const uint32_t INDEX_VERSION = 1;
+static const size_t PAGE_SIZE = 4096;
+static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t prefixOf(const uint8_t *hash160) {
+  return ((uint32_t)hash160[0] << 24) | ((uint32_t)hash160[1] << 16) |
+         ((uint32_t)hash160[2] << 8) | (uint32_t)hash160[3];
+}
+
+TargetIndex::~TargetIndex() { Close(); }
+
+bool TargetIndex::Write(const std::string &path, std::vector<uint8_t> &hashes,
+                        std::string &error) {
+  // Sort 20-byte records through an index array, then compact them in order.
+  size_t n = hashes.size() / 20;
+  std::vector<uint32_t> order(n);
+  for (size_t i = 0; i < n; i++) order[i] = (uint32_t)i;
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return memcmp(&hashes[(size_t)a * 20], &hashes[(size_t)b * 20], 20) < 0;
+  });
+  std::vector<uint8_t> sorted;
+  sorted.reserve(n * 20);
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t *h = &hashes[(size_t)order[i] * 20];
+    if (!sorted.empty() && memcmp(&sorted[sorted.size() - 20], h, 20) == 0) continue;
+    sorted.insert(sorted.end(), h, h + 20);
+  }
+  n = sorted.size() / 20;
+  if (n > UINT32_MAX) {
+    error = "too many targets for one index";
+    return false;
+  }
+
+  // About four targets per bucket and one filter slot per target.
+  TargetIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header.version = INDEX_VERSION;
+  header.count = (uint32_t)n;
+  header.prefixBits = 8;
+  while (header.prefixBits < 24 && ((size_t)4 << header.prefixBits) < n) header.prefixBits++;
+  header.filterBits = 8;
+  while (header.filterBits < 31 && ((size_t)1 << header.filterBits) < n) header.filterBits++;
+
+  std::vector<uint32_t> filter((size_t)1 << header.filterBits, 0);
+  const int filterShift = 32 - header.filterBits;
+  for (size_t i = 0; i < n; i++) {
+    uint32_t w0, w1;
+    memcpy(&w0, &sorted[i * 20], 4);
+    memcpy(&w1, &sorted[i * 20 + 4], 4);
+    filter[w0 >> filterShift] |= (1u << (w0 & 31)) | (1u << (w1 & 31));
+  }
+
+  const size_t buckets = (size_t)1 << header.prefixBits;
+  const int prefixShift = 32 - header.prefixBits;
+  std::vector<uint32_t> directory(buckets + 1);
+  size_t next = 0;
+  for (size_t b = 0; b <= buckets; b++) {
+    while (next < n && (prefixOf(&sorted[next * 20]) >> prefixShift) < b) next++;
+    directory[b] = (uint32_t)next;
+  }
+
+  header.filterOffset = PAGE_SIZE;
+  header.directoryOffset = alignUp(header.filterOffset + filter.size() * 4, PAGE_SIZE);
+  header.hashesOffset = alignUp(header.directoryOffset + directory.size() * 4, PAGE_SIZE);
+  header.fileSize = header.hashesOffset + sorted.size();
+
+  FILE *out = fopen(path.c_str(), "wb");
+  if (!out) {
+    error = "cannot create " + path;
+    return false;
+  }
+  std::vector<uint8_t> padding(PAGE_SIZE, 0);
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+            fwrite(padding.data(), 1, header.filterOffset - sizeof(header), out) ==
+                header.filterOffset - sizeof(header) &&
+            fwrite(filter.data(), 4, filter.size(), out) == filter.size();
+  uint64_t written = header.filterOffset + filter.size() * 4;
+  ok = ok && fwrite(padding.data(), 1, header.directoryOffset - written, out) ==
+                 header.directoryOffset - written;
+  ok = ok && fwrite(directory.data(), 4, directory.size(), out) == directory.size();
+  written = header.directoryOffset + directory.size() * 4;
+  ok = ok && fwrite(padding.data(), 1, header.hashesOffset - written, out) ==
+                 header.hashesOffset - written;
+  ok = ok && fwrite(sorted.data(), 1, sorted.size(), out) == sorted.size();
+  ok = (fclose(out) == 0) && ok;
+  if (!ok) error = "write to " + path + " failed";
+  return ok;
+}
+
+bool TargetIndex::Open(const std::string &path, bool hugePages, std::string &error) {
+  Close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    error = "cannot open " + path;
+    return false;
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(file, &size);
+  mappingSize = (size_t)size.QuadPart;
+  const size_t fileBytes = mappingSize;
+  HANDLE view = mappingSize ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+  CloseHandle(file);
+  if (view) {
+    mapping = (uint8_t *)MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(view);
+  }
+  if (!mapping) {
+    error = "cannot map " + path;
+    return false;
+  }
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = "cannot open " + path;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    error = "cannot read " + path;
+    return false;
+  }
+  mappingSize = (size_t)st.st_size;
+  const size_t fileBytes = mappingSize;
+
+#ifdef MAP_HUGETLB
+  if (hugePages) {
+    // Explicit huge pages cannot back a regular file, so the index is read into them.
+    size_t hugeSize = alignUp(mappingSize, HUGE_PAGE_SIZE);
+    void *p = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      size_t done = 0;
+      while (done < mappingSize) {
+        ssize_t r = pread(fd, (uint8_t *)p + done, mappingSize - done, (off_t)done);
+        if (r <= 0) break;
+        done += (size_t)r;
+      }
+      if (done == mappingSize && mprotect(p, hugeSize, PROT_READ) == 0) {
+        mapping = (uint8_t *)p;
+        mappingSize = hugeSize;
+        hugePageCopy = true;
+      } else {
+        munmap(p, hugeSize);
+      }
+    }
+  }
+#endif
+  if (!mapping) {
+    void *p = mmap(NULL, mappingSize, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      error = "cannot map " + path;
+      return false;
+    }
+    mapping = (uint8_t *)p;
+#ifdef MADV_HUGEPAGE
+    if (hugePages) madvise(p, mappingSize, MADV_HUGEPAGE);
+#endif
+    madvise(p, mappingSize, MADV_RANDOM);
+  }
+  close(fd);
+#endif
+
+  TargetIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(&header, mapping, std::min(sizeof(header), fileBytes));
+  const uint64_t filterBytes = (uint64_t)4 << (header.filterBits & 31);
+  const uint64_t directoryBytes = ((uint64_t)4 << (header.prefixBits & 31)) + 4;
+  if (fileBytes < sizeof(header) || memcmp(header.magic, INDEX_MAGIC, 8) != 0) {
+    error = path + " is not a target index";
+  } else if (header.version != INDEX_VERSION) {
+    error = path + ": unsupported index version " + std::to_string(header.version);
+  } else if (header.prefixBits < 1 || header.prefixBits > 24 || header.filterBits < 1 ||
+             header.filterBits > 31 || header.fileSize > fileBytes ||
+             header.filterOffset + filterBytes > header.fileSize ||
+             header.directoryOffset + directoryBytes > header.fileSize ||
+             header.hashesOffset + (uint64_t)header.count * 20 > header.fileSize) {
+    error = path + " is truncated or corrupt";
+  } else {
+    filter = (const uint32_t *)(mapping + header.filterOffset);
+    directory = (const uint32_t *)(mapping + header.directoryOffset);
+    hashes = mapping + header.hashesOffset;
+    count = header.count;
+    filterShift = 32 - header.filterBits;
+    prefixShift = 32 - header.prefixBits;
+    // Confirm searches buckets without bounds checks, so they must run in order from 0 to
+    // count; the hashes section was checked to hold count hashes.
+    const size_t buckets = (size_t)1 << header.prefixBits;
+    bool ordered = directory[0] == 0 && directory[buckets] == count;
+    for (size_t b = 0; ordered && b < buckets; b++) ordered = directory[b] <= directory[b + 1];
+    if (ordered) return true;
+    error = path + ": bucket directory is corrupt";
+  }
+  Close();
+  return false;
+}
+
+void TargetIndex::Close() {
+  if (mapping) {
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, mappingSize);
+#endif
+  }
+  mapping = nullptr;
+  mappingSize = 0;
+  hugePageCopy = false;
+  filter = nullptr;
+  directory = nullptr;
+  hashes = nullptr;
+  count = 0;
+}
+
+__mmask16 TargetIndex::Probe(const __m512i hash[5]) const {
+  if (count == 0) return 0;
+  const __m512i slot = srl_epi32(hash[0], _mm_cvtsi32_si128(filterShift));
+  const __m512i block = gather_epi32(slot, filter);
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i low5 = _mm512_set1_epi32(31);
+  const __m512i bits =
+      _mm512_or_si512(sllv_epi32(one, _mm512_and_si512(hash[0], low5)),
+                      sllv_epi32(one, _mm512_and_si512(hash[1], low5)));
+  return _mm512_cmpeq_epi32_mask(_mm512_and_si512(block, bits), bits);
+}
+
+__mmask16 TargetIndex::Confirm(const __m512i hash[5], __mmask16 lanes,
+                               uint32_t found[16]) const {
+  if (!lanes) return 0;
+  // hash[0] holds the first four bytes little-endian; the buckets follow the sort order.
+  const __m512i bucket = srl_epi32(bswap_epi32(hash[0]), _mm_cvtsi32_si128(prefixShift));
+  const __m512i zero = _mm512_setzero_si512();
+  alignas(64) uint32_t lo[16], hi[16], words[5][16];
+  _mm512_store_epi32(lo, _mm512_mask_i32gather_epi32(zero, lanes, bucket, directory, 4));
+  _mm512_store_epi32(hi, _mm512_mask_i32gather_epi32(
+                             zero, lanes, _mm512_add_epi32(bucket, _mm512_set1_epi32(1)),
+                             directory, 4));
+  for (int w = 0; w < 5; w++) _mm512_store_epi32(words[w], hash[w]);
+
+  __mmask16 confirmed = 0;
+  while (lanes) {
+    const int lane = __builtin_ctz(lanes);
+    lanes &= lanes - 1;
+    uint8_t hash160[20];
+    for (int w = 0; w < 5; w++) memcpy(hash160 + w * 4, &words[w][lane], 4);
+    const int64_t index = Search(hash160, lo[lane], hi[lane]);
+    if (index >= 0) {
+      found[lane] = (uint32_t)index;
+      confirmed |= (__mmask16)(1u << lane);
+    }
+  }
+  return confirmed;
+}
+
+int64_t TargetIndex::Find(const uint8_t *hash160) const {
+  if (count == 0) return -1;
+  const uint32_t bucket = prefixOf(hash160) >> prefixShift;
+  return Search(hash160, directory[bucket], directory[bucket + 1]);
+}
+
+int64_t TargetIndex::Search(const uint8_t *hash160, uint32_t lo, uint32_t hi) const {
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const int c = memcmp(Hash(mid), hash160, 20);
+    if (c == 0) return mid;
+    if (c < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return -1;
+}
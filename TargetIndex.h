@@ -0,0 +1,73 @@
+#ifndef TARGETINDEXH
+#define TARGETINDEXH
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// On-disk layout of a target index, built by "mutagen index". Every section starts on a page
+// boundary so the file can be mapped as is:
+//   header | filter (2^filterBits uint32) | directory (2^prefixBits + 1 uint32) | hashes
+// The hashes are sorted, unique 20-byte hash160s. directory[b] is the first hash whose top
+// prefixBits bits (read big-endian) are >= b, so bucket b is [directory[b], directory[b + 1]).
+// The filter is the same blocked Bloom filter as TargetSet's, one slot per target.
+struct TargetIndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t prefixBits;
+  uint32_t filterBits;
+  uint32_t count;
+  uint64_t filterOffset;
+  uint64_t directoryOffset;
+  uint64_t hashesOffset;
+  uint64_t fileSize;
+};
+
+// Read-only view of a target index file, mapped once and shared by all worker threads.
+class TargetIndex {
+ public:
+  TargetIndex() {}
+  ~TargetIndex();
+  TargetIndex(const TargetIndex &) = delete;
+  TargetIndex &operator=(const TargetIndex &) = delete;
+
+  // Sorts and deduplicates the hash160s (20 bytes each) and writes them as an index file.
+  static bool Write(const std::string &path, std::vector<uint8_t> &hashes, std::string &error);
+
+  // Maps an index file. With hugePages the file is copied into a huge-page backed anonymous
+  // mapping when the system has huge pages reserved, otherwise the file mapping is advised to
+  // use transparent huge pages.
+  bool Open(const std::string &path, bool hugePages, std::string &error);
+  void Close();
+
+  uint32_t Size() const { return count; }
+  bool UsesHugePages() const { return hugePageCopy; }
+  const uint8_t *Hash(uint32_t index) const { return hashes + (size_t)index * 20; }
+
+  // Lanes of the transposed hash160s (hash[w] holds word w of every lane) that may be targets.
+  __mmask16 Probe(const __m512i hash[5]) const;
+  // Confirms the candidate lanes of a batch: the bucket bounds of all of them are gathered
+  // from the directory at once, then each is searched. Returns the lanes that are targets and
+  // stores the index of each in found[lane].
+  __mmask16 Confirm(const __m512i hash[5], __mmask16 lanes, uint32_t found[16]) const;
+  // Index of the target with this hash160, or -1.
+  int64_t Find(const uint8_t *hash160) const;
+
+ private:
+  int64_t Search(const uint8_t *hash160, uint32_t lo, uint32_t hi) const;
+
+  uint8_t *mapping = nullptr;
+  size_t mappingSize = 0;
+  bool hugePageCopy = false;
+  const uint32_t *filter = nullptr;
+  const uint32_t *directory = nullptr;
+  const uint8_t *hashes = nullptr;
+  uint32_t count = 0;
+  int filterShift = 32;
+  int prefixShift = 32;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "TargetSet.h"
+#include "simd_avx512.h"
+
+static bool hashLess(const Target &a, const Target &b) {
+  return memcmp(a.hash160, b.hash160, 20) < 0;
+}
+
+void TargetSet::Add(const uint8_t *hash160, const std::string &label) {
+  Target t;
+  memcpy(t.hash160, hash160, 20);
+  t.label = label;
+  targets.push_back(t);
+}
+
+bool ParseHash160(const char *hex, size_t length, uint8_t *hash160) {
+  if (length != 40) return false;
+  for (int i = 0; i < 20; i++) {
+    int value = 0;
+    for (int j = 0; j < 2; j++) {
+      char c = hex[i * 2 + j];
+      int digit;
+      if (c >= '0' && c <= '9') {
+        digit = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        digit = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        digit = c - 'A' + 10;
+      } else {
+        return false;
+      }
+      value = value * 16 + digit;
+    }
+    hash160[i] = (uint8_t)value;
+  }
+  return true;
+}
+
+bool ParseHash160(const std::string &hex, uint8_t *hash160) {
+  return ParseHash160(hex.data(), hex.length(), hash160);
+}
+
+bool TargetSet::AddHex(const std::string &hex, const std::string &label) {
+  uint8_t hash160[20];
+  if (!ParseHash160(hex, hash160)) return false;
+  Add(hash160, label);
+  return true;
+}
+
+void TargetSet::Build() {
+  std::stable_sort(targets.begin(), targets.end(), hashLess);
+  targets.erase(std::unique(targets.begin(), targets.end(),
+                            [](const Target &a, const Target &b) {
+                              return memcmp(a.hash160, b.hash160, 20) == 0;
+                            }),
+                targets.end());
+
+  if (!targets.empty()) memcpy(firstWords, targets[0].hash160, 20);
+
+  // Two slots per target keeps the false positive rate well under 1%.
+  int slotBits = 8;
+  while (slotBits < 31 && ((size_t)1 << slotBits) < 2 * targets.size()) slotBits++;
+  filter.assign((size_t)1 << slotBits, 0);
+  filterShift = 32 - slotBits;
+
+  for (const Target &t : targets) {
+    uint32_t w0, w1;
+    memcpy(&w0, t.hash160, 4);
+    memcpy(&w1, t.hash160 + 4, 4);
+    filter[w0 >> filterShift] |= (1u << (w0 & 31)) | (1u << (w1 & 31));
+  }
+}
+
+__mmask16 TargetSet::Probe(const __m512i hash[5]) const {
+  if (targets.size() == 1) {
+    // A single target is cheaper to compare outright, one word at a time.
+    __mmask16 m = _mm512_cmpeq_epi32_mask(hash[0], _mm512_set1_epi32(firstWords[0]));
+    for (int w = 1; w < 5 && m; w++) {
+      m &= _mm512_cmpeq_epi32_mask(hash[w], _mm512_set1_epi32(firstWords[w]));
+    }
+    return m;
+  }
+  if (targets.empty()) return 0;
+
+  const __m512i slot = srl_epi32(hash[0], _mm_cvtsi32_si128(filterShift));
+  const __m512i block = gather_epi32(slot, filter.data());
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i low5 = _mm512_set1_epi32(31);
+  const __m512i bits =
+      _mm512_or_si512(sllv_epi32(one, _mm512_and_si512(hash[0], low5)),
+                      sllv_epi32(one, _mm512_and_si512(hash[1], low5)));
+  return _mm512_cmpeq_epi32_mask(_mm512_and_si512(block, bits), bits);
+}
+
+int TargetSet::Find(const uint8_t *hash160) const {
+  Target key;
+  memcpy(key.hash160, hash160, 20);
+  auto it = std::lower_bound(targets.begin(), targets.end(), key, hashLess);
+  if (it == targets.end() || memcmp(it->hash160, hash160, 20) != 0) return -1;
+  return (int)(it - targets.begin());
+}
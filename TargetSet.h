@@ -0,0 +1,46 @@
+#ifndef TARGETSETH
+#define TARGETSETH
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+struct Target {
+  uint8_t hash160[20];
+  std::string label;
+};
+
+// Parses 40 hex digits into 20 bytes; returns false if the string is not a hash160.
+bool ParseHash160(const char *hex, size_t length, uint8_t *hash160);
+bool ParseHash160(const std::string &hex, uint8_t *hash160);
+
+// Set of hash160 targets checked against every batch of 16 candidate hashes. A blocked Bloom
+// filter (one 32-bit block per slot, two bits per target) small enough to stay in cache is
+// probed for all 16 lanes with one gather; lanes that pass are confirmed with Find().
+class TargetSet {
+ public:
+  void Add(const uint8_t *hash160, const std::string &label);
+  // Parses 40 hex digits; returns false if the string is not a hash160.
+  bool AddHex(const std::string &hex, const std::string &label);
+  // Sorts the targets, drops duplicates and builds the filter. Call after the last Add.
+  void Build();
+
+  int Size() const { return (int)targets.size(); }
+  const Target &Get(int index) const { return targets[index]; }
+
+  // Lanes of the transposed hash160s (hash[w] holds word w of every lane) that may be targets.
+  __mmask16 Probe(const __m512i hash[5]) const;
+  // Index of the target with this hash160, or -1.
+  int Find(const uint8_t *hash160) const;
+
+ private:
+  std::vector<Target> targets;
+  std::vector<uint32_t> filter;
+  int filterShift = 32;
+  uint32_t firstWords[5] = {0};
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hash160_avx512.h"
+#include "ripemd160_avx512.h"
+#include "sha256_avx512.h"
+#include "simd_avx512.h"
+#include "transpose_avx512.h"
+
+// RIPEMD-160 of the SHA-256 digests, taken from the transposed state words.
+static inline void ripemdOfState(__m512i state[8], __m512i hash[5]) {
+  // SHA-256 state words are the big-endian digest words; RIPEMD-160 reads the digest as
+  // little-endian words, so a byte swap per lane turns one into the other.
+  for (int w = 0; w < 8; ++w) state[w] = bswap_epi32(state[w]);
+
+  ripemd160avx512::ripemd160avx512_16(state, hash);
+}
+
+void hash160avx512_16(const uint8_t* pubKeys[16], __m512i hash[5]) {
+  __m512i state[8];
+  sha256avx512_16_33(pubKeys, state);
+  ripemdOfState(state, hash);
+}
+
+void hash160avx512_16(const __m512i message[9], __m512i hash[5]) {
+  __m512i state[8];
+  sha256avx512_16_33(message, state);
+  ripemdOfState(state, hash);
+}
+
+void hash160avx512_message(const uint64_t* x[16], const uint32_t yOdd[16], __m512i message[9]) {
+  const uint8_t* rows[16];
+  for (int i = 0; i < 16; ++i) rows[i] = reinterpret_cast<const uint8_t*>(x[i]);
+  __m512i limbs[8];
+  transpose16x8_epi32(rows, 0, limbs);
+
+  // The key is the prefix byte followed by the x words from the most significant down, so
+  // every message word is the low byte of the previous word and the top three of the next.
+  __m512i previous = _mm512_or_si512(_mm512_load_epi32(yOdd), _mm512_set1_epi32(0x02));
+  for (int w = 0; w < 8; ++w) {
+    const __m512i current = limbs[7 - w];
+    message[w] = _mm512_or_si512(slli_epi32(previous, 24), srli_epi32(current, 8));
+    previous = current;
+  }
+  // Last byte of x, then the 0x80 terminator.
+  message[8] = _mm512_or_si512(slli_epi32(previous, 24), _mm512_set1_epi32(0x00800000));
+}
+
+void hash160avx512_lane(const __m512i hash[5], int lane, uint8_t* output) {
+  alignas(64) uint32_t words[16];
+  for (int w = 0; w < 5; ++w) {
+    _mm512_store_epi32(words, hash[w]);
+    memcpy(output + w * 4, &words[lane], 4);
+  }
+}
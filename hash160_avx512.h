@@ -0,0 +1,22 @@
+#ifndef HASH160_AVX512_H
+#define HASH160_AVX512_H
+
+#include <immintrin.h>
+#include <stdint.h>
+
+// RIPEMD-160(SHA-256(pubkey)) of 16 33-byte compressed public keys. The SHA-256 state stays in
+// registers and becomes the RIPEMD-160 message directly. hash[w] receives word w of every lane's
+// hash160 (little-endian, i.e. bytes 4w..4w+3 of the digest as a host integer).
+void hash160avx512_16(const uint8_t* pubKeys[16], __m512i hash[5]);
+
+// Same, starting from the transposed SHA-256 message words 0..8 of the keys.
+void hash160avx512_16(const __m512i message[9], __m512i hash[5]);
+
+// Builds the transposed SHA-256 message words 0..8 of 16 compressed public keys directly from
+// their x coordinates (four little-endian 64-bit limbs each) and the parity of y (0 or 1).
+void hash160avx512_message(const uint64_t* x[16], const uint32_t yOdd[16], __m512i message[9]);
+
+// Extracts the 20-byte hash160 of one lane from the transposed words.
+void hash160avx512_lane(const __m512i hash[5], int lane, uint8_t* output);
+
+#endif  // HASH160_AVX512_H
@@ -8,10 +8,13 @@
 #include <chrono>
 #include <cmath>
 #include <csignal>
+#include <condition_variable>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <random>
@@ -21,156 +24,264 @@
 #include <vector>
 
 #ifdef _WIN32
+#include <io.h>
 #include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 
+#include "ChunkScheduler.h"
+#include "Coordinator.h"
 #include "Int.h"
 #include "IntGroup.h"
 #include "Point.h"
 #include "SECP256K1.h"
+#include "TargetFile.h"
+#include "TargetIndex.h"
+#include "TargetSet.h"
+#include "hash160_avx512.h"
 #include "ripemd160_avx512.h"
 #include "sha256_avx512.h"
+#include "simd_avx512.h"
 
 using namespace std;
 
 // === SMART LOGGER CLASS ===
+// How much goes to the analysis log. Off by default; debug adds sampled per-combination
+// records from the search loop.
+enum LogLevel { LOG_OFF, LOG_INFO, LOG_DEBUG };
+LogLevel LOG_LEVEL = LOG_OFF;
+const char* const LOG_FILE = "avx512_log.txt";
+
+// Writes the analysis log without slowing the search down: every thread formats its records
+// into a ring buffer of its own, and a background thread drains all rings in batches, in
+// timestamp order, with one flush per batch. A full ring drops records instead of waiting.
 class SmartMutagenLogger {
  private:
+  static constexpr size_t RECORD_SIZE = 496;
+  static constexpr uint64_t RING_RECORDS = 256;
+  static constexpr int DRAIN_PERIOD_MS = 100;
+
+  struct Record {
+    double seconds;
+    uint32_t length;
+    char text[RECORD_SIZE];
+  };
+  // Single producer, single consumer: the owning thread advances head, the writer tail.
+  struct Ring {
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> owned{false};
+    Record records[RING_RECORDS];
+  };
+  // Gives a thread's ring back when the thread exits, so threads started per lease reuse them.
+  struct RingLease {
+    std::shared_ptr<Ring> ring;
+    ~RingLease() {
+      if (ring) ring->owned.store(false, std::memory_order_release);
+    }
+  };
+
   std::ofstream logFile;
-  std::mutex logMutex;
+  LogLevel level;
   std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
-  uint64_t combinationCounter = 0;
-  uint64_t lastLoggedCombination = 0;
-
-  std::string getCurrentTimestamp() {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - startTime);
+  std::mutex ringsMutex;  // guards rings; taken once per thread, never per record
+  std::vector<std::shared_ptr<Ring>> rings;
+  std::thread writer;
+  std::mutex writerMutex;
+  std::condition_variable writerWake;
+  bool stopping = false;
+
+  std::string getCurrentTimestamp(double seconds) {
     std::ostringstream oss;
-    oss << "[" << std::fixed << std::setprecision(6) << elapsed.count() / 1000000.0 << "s] ";
+    oss << "[" << std::fixed << std::setprecision(6) << seconds << "s] ";
     return oss.str();
   }
 
+  Ring& threadRing() {
+    thread_local RingLease lease;
+    if (!lease.ring) {
+      std::lock_guard<std::mutex> lock(ringsMutex);
+      for (auto& ring : rings) {
+        bool expected = false;
+        if (ring->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+          lease.ring = ring;
+          break;
+        }
+      }
+      if (!lease.ring) {
+        lease.ring = std::make_shared<Ring>();
+        lease.ring->owned.store(true);
+        rings.push_back(lease.ring);
+      }
+    }
+    return *lease.ring;
+  }
+
+  void push(const std::string& text) {
+    Ring& ring = threadRing();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == RING_RECORDS) {
+      ring.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    Record& record = ring.records[head % RING_RECORDS];
+    record.seconds =
+        std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime)
+            .count();
+    record.length = (uint32_t)std::min(text.size(), RECORD_SIZE);
+    memcpy(record.text, text.data(), record.length);
+    ring.head.store(head + 1, std::memory_order_release);
+  }
+
+  // Writes out everything queued so far. Only the writer thread, or the destructor once it has
+  // stopped, calls this.
+  void drain() {
+    std::vector<std::shared_ptr<Ring>> snapshot;
+    {
+      std::lock_guard<std::mutex> lock(ringsMutex);
+      snapshot = rings;
+    }
+    std::vector<std::pair<double, std::string>> batch;
+    uint64_t dropped = 0;
+    for (auto& ring : snapshot) {
+      const uint64_t head = ring->head.load(std::memory_order_acquire);
+      uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+      for (; tail < head; tail++) {
+        const Record& record = ring->records[tail % RING_RECORDS];
+        batch.emplace_back(record.seconds, std::string(record.text, record.length));
+      }
+      ring->tail.store(tail, std::memory_order_release);
+      dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+    }
+    if (batch.empty() && dropped == 0) return;
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const std::pair<double, std::string>& a,
+                        const std::pair<double, std::string>& b) { return a.first < b.first; });
+    for (const auto& entry : batch) {
+      logFile << getCurrentTimestamp(entry.first) << entry.second << "\n";
+    }
+    if (dropped > 0) logFile << "[LOG] " << dropped << " records dropped, rings were full\n";
+    logFile.flush();
+  }
+
+  void writeLoop() {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (!stopping) {
+      writerWake.wait_for(lock, std::chrono::milliseconds(DRAIN_PERIOD_MS));
+      lock.unlock();
+      drain();
+      lock.lock();
+    }
+  }
+
+  static std::string joinFlips(const std::vector<int>& flips) {
+    std::string text = "[";
+    for (size_t i = 0; i < flips.size(); ++i) {
+      if (i > 0) text += ", ";
+      text += std::to_string(flips[i]);
+    }
+    return text + "]";
+  }
+
+  // The bits set in a flip mask.
+  static std::string joinFlips(__uint128_t mask) {
+    std::vector<int> flips;
+    for (int bit = 0; bit < 128; bit++) {
+      if ((mask >> bit) & 1) flips.push_back(bit);
+    }
+    return joinFlips(flips);
+  }
+
  public:
-  SmartMutagenLogger(const std::string& filename = "avx512_log.txt")
-      : logFile(filename), startTime(std::chrono::high_resolution_clock::now()) {
+  SmartMutagenLogger(const std::string& filename, LogLevel level)
+      : logFile(filename), level(level), startTime(std::chrono::high_resolution_clock::now()) {
     if (logFile.is_open()) {
       logFile << "========== MUTAGEN AVX512 ALGORITHM ANALYSIS ==========" << std::endl;
-      logFile << "Start Time: " << getCurrentTimestamp() << std::endl;
+      logFile << "Start Time: " << getCurrentTimestamp(0.0) << std::endl;
       logFile << "Purpose: Understand how bit flipping mutation works - AVX512 VERSION"
               << std::endl;
+      logFile << "Log level: " << (level == LOG_DEBUG ? "debug" : "info") << std::endl;
       logFile << "=====================================================" << std::endl;
       logFile.flush();
+      writer = std::thread(&SmartMutagenLogger::writeLoop, this);
     }
   }
 
   ~SmartMutagenLogger() {
     if (logFile.is_open()) {
+      {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        stopping = true;
+      }
+      writerWake.notify_one();
+      writer.join();
+      drain();
       logFile << "\n========== AVX512 ANALYSIS COMPLETE ==========" << std::endl;
       logFile.close();
     }
   }
 
+  bool Enabled(LogLevel needed) const { return logFile.is_open() && level >= needed; }
+
   void logOperation(const std::string& operation, const std::string& details = "") {
-    std::lock_guard<std::mutex> lock(logMutex);
-    if (logFile.is_open()) {
-      logFile << getCurrentTimestamp() << "[" << operation << "] " << details << std::endl;
-      logFile.flush();
-    }
+    if (!Enabled(LOG_INFO)) return;
+    push("[" + operation + "] " + details);
   }
 
-  void logKeyMutationStrategy(int threadId, const std::string& baseKey,
-                              const std::vector<int>& flips, const std::string& mutatedKey,
+  // Sampled: the first 10 combinations of the search and then every 10000th.
+  void logKeyMutationStrategy(int threadId, Int& baseKey, __uint128_t flips, Int& mutatedKey,
                               uint64_t combinationIndex) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    if (logFile.is_open()) {
-      logFile << "\n" << getCurrentTimestamp() << "=== KEY MUTATION STEP (AVX512) ===" << std::endl;
-      logFile << "Thread: " << threadId << " | Combination #" << combinationIndex << std::endl;
-      logFile << "Base Key (hex): " << baseKey << std::endl;
-      logFile << "Base Key (dec): " << std::stoull(baseKey, nullptr, 16) << std::endl;
-      logFile << "Bit positions to flip: [";
-      for (size_t i = 0; i < flips.size(); ++i) {
-        logFile << flips[i];
-        if (i < flips.size() - 1) logFile << ", ";
-      }
-      logFile << "]" << std::endl;
-      logFile << "After flipping bits: " << mutatedKey << std::endl;
-      logFile << "Mutated Key (dec): " << std::stoull(mutatedKey, nullptr, 16) << std::endl;
-
-      // Show which bits changed
-      uint64_t baseVal = std::stoull(baseKey, nullptr, 16);
-      uint64_t mutatedVal = std::stoull(mutatedKey, nullptr, 16);
-      uint64_t diff = baseVal ^ mutatedVal;
-      logFile << "XOR difference: 0x" << std::hex << diff << std::dec << std::endl;
-      logFile << "=========================" << std::endl;
-      logFile.flush();
-    }
+    if (!Enabled(LOG_DEBUG) || (combinationIndex >= 10 && combinationIndex % 10000 != 0)) return;
+    Int difference(&mutatedKey);
+    difference.Xor(&baseKey);
+    std::ostringstream text;
+    text << "=== KEY MUTATION STEP (AVX512) ===\n";
+    text << "Thread: " << threadId << " | Combination #" << combinationIndex << "\n";
+    text << "Base Key (hex): " << baseKey.GetBase16() << "\n";
+    text << "Base Key (dec): " << baseKey.GetBase10() << "\n";
+    text << "Bit positions to flip: " << joinFlips(flips) << "\n";
+    text << "After flipping bits: " << mutatedKey.GetBase16() << "\n";
+    text << "Mutated Key (dec): " << mutatedKey.GetBase10() << "\n";
+    text << "XOR difference: 0x" << difference.GetBase16() << "\n";
+    text << "=========================";
+    push(text.str());
   }
 
   void logAlgorithmStep(const std::string& step, const std::string& explanation) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    if (logFile.is_open()) {
-      logFile << getCurrentTimestamp() << "[ALGORITHM] " << step << ": " << explanation
-              << std::endl;
-      logFile.flush();
-    }
+    if (!Enabled(LOG_INFO)) return;
+    push("[ALGORITHM] " + step + ": " + explanation);
   }
 
-  void logCombinationGeneration(int threadId, uint64_t combinationIndex,
-                                const std::vector<int>& combination) {
-    // Only log first 10 combinations, then every 10000th, then around solution
-    bool shouldLog =
-        (combinationIndex < 10) || (combinationIndex % 10000 == 0) ||
-        (combinationIndex > lastLoggedCombination + 5000);  // Log more frequently near solution
-
-    if (shouldLog) {
-      std::lock_guard<std::mutex> lock(logMutex);
-      if (logFile.is_open()) {
-        logFile << getCurrentTimestamp() << "[COMBINATION_GEN] Thread" << threadId
-                << " | Index: " << combinationIndex << " | Bits to flip: [";
-        for (size_t i = 0; i < combination.size(); ++i) {
-          logFile << combination[i];
-          if (i < combination.size() - 1) logFile << ", ";
-        }
-        logFile << "]" << std::endl;
-        logFile.flush();
-        lastLoggedCombination = combinationIndex;
-      }
-    }
+  // Sampled like logKeyMutationStrategy; cheap enough to call for every combination.
+  void logCombinationGeneration(int threadId, uint64_t combinationIndex, __uint128_t combination) {
+    if (!Enabled(LOG_DEBUG) || (combinationIndex >= 10 && combinationIndex % 10000 != 0)) return;
+    push("[COMBINATION_GEN] Thread" + std::to_string(threadId) +
+         " | Index: " + std::to_string(combinationIndex) +
+         " | Bits to flip: " + joinFlips(combination));
   }
 
   void logSolutionAnalysis(const std::string& privateKey, const std::string& hash160,
                            uint64_t totalChecked, const std::vector<int>& solutionFlips) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    if (logFile.is_open()) {
-      logFile << "\n"
-              << getCurrentTimestamp() << "========== SOLUTION ANALYSIS ==========" << std::endl;
-      logFile << "SOLUTION FOUND!" << std::endl;
-      logFile << "Private Key: " << privateKey << std::endl;
-      logFile << "Hash160: " << hash160 << std::endl;
-      logFile << "Total combinations checked: " << totalChecked << std::endl;
-      logFile << "Solution required flipping bits: [";
-      for (size_t i = 0; i < solutionFlips.size(); ++i) {
-        logFile << solutionFlips[i];
-        if (i < solutionFlips.size() - 1) logFile << ", ";
-      }
-      logFile << "]" << std::endl;
-      logFile << "=======================================" << std::endl;
-      logFile.flush();
-    }
+    if (!Enabled(LOG_INFO)) return;
+    push("========== SOLUTION ANALYSIS ==========\nSOLUTION FOUND!\nPrivate Key: " +
+         privateKey + "\nHash160: " + hash160 +
+         "\nTotal keys checked: " + std::to_string(totalChecked) +
+         "\nSolution required flipping bits: " + joinFlips(solutionFlips) +
+         "\n=======================================");
   }
 
-  void logProgress(uint64_t totalChecked, uint64_t totalCombinations, double speed) {
-    // Only log every 50000 combinations
-    if (totalChecked % 50000 == 0) {
-      std::lock_guard<std::mutex> lock(logMutex);
-      if (logFile.is_open()) {
-        double progress = (double)totalChecked / totalCombinations * 100.0;
-        logFile << getCurrentTimestamp() << "[PROGRESS] " << totalChecked << "/"
-                << totalCombinations << " (" << std::fixed << std::setprecision(2) << progress
-                << "%) " << "Speed: " << speed << " Mkeys/s" << std::endl;
-        logFile.flush();
-      }
-    }
+  // Called once per progress refresh.
+  void logProgress(uint64_t totalChecked, uint64_t totalKeys, double speed) {
+    if (!Enabled(LOG_INFO)) return;
+    std::ostringstream text;
+    text << "[PROGRESS] " << totalChecked << "/" << totalKeys << " (" << std::fixed
+         << std::setprecision(2) << (double)totalChecked / totalKeys * 100.0 << "%) "
+         << "Speed: " << speed << " Mkeys/s";
+    push(text.str());
   }
 };
 
@@ -214,9 +325,71 @@ void moveCursorTo(int x, int y) {
 int PUZZLE_NUM = 20;
 int WORKERS = omp_get_num_procs();
 int FLIP_COUNT = -1;
-const __uint128_t REPORT_INTERVAL = 10000000;
+// --flips-min/--flips-max: search every flip count in FLIPS_MIN..FLIPS_MAX in one rank space.
+int FLIPS_MIN = -1;
+int FLIPS_MAX = -1;
+bool GRAY_ORDER = false;
+// The progress display is redrawn this often.
+static constexpr int REPORT_PERIOD_MS = 1000;
 static constexpr int POINTS_BATCH_SIZE = 512;
 static constexpr int HASH_BATCH_SIZE = 16;
+static constexpr int COMBINATION_BATCH_SIZE = 8;
+// Work-stealing granularity: keys per chunk, and a floor in combinations for wide windows.
+static constexpr uint64_t CHUNK_KEYS = 1 << 20;
+static constexpr uint64_t MIN_CHUNK_COMBINATIONS = 256;
+static constexpr int MAX_RADIUS = 1 << 16;
+int RADIUS = POINTS_BATCH_SIZE - 1;
+// Keep searching after a hit and report every one instead of stopping at the first.
+bool CONTINUE_ON_MATCH = false;
+string TARGETS_FILE;
+bool ALL_PUZZLE_TARGETS = false;
+string INDEX_FILE;
+bool INDEX_HUGE_PAGES = false;
+string RESULTS_FILE;
+// Prometheus textfile snapshot, replaced every REPORT_PERIOD_MS (--metrics-file).
+string METRICS_FILE;
+// Every thread's rank ranges are saved to CHECKPOINT_FILE every CHECKPOINT_INTERVAL seconds
+// (0 disables it) and once more on exit; --resume continues from that file.
+string CHECKPOINT_FILE;
+int CHECKPOINT_INTERVAL = 60;
+bool RESUME = false;
+// --shard I/N: the ranks are cut into SHARD_COUNT * SHARD_BLOCKS blocks and this process
+// searches every SHARD_COUNT-th of them, starting with block SHARD_INDEX.
+int SHARD_INDEX = 0;
+int SHARD_COUNT = 1;
+static constexpr int SHARD_BLOCKS = 64;
+static constexpr int MAX_SHARDS = 1 << 20;
+// --serve leases the ranks to worker processes started with --connect. A lease covers
+// LEASE_CHUNKS chunks per worker thread and goes back to the pool after LEASE_TIMEOUT
+// seconds without a progress report.
+string SERVE_ADDRESS;
+string CONNECT_ADDRESS;
+int LEASE_TIMEOUT = 60;
+static constexpr int LEASE_CHUNKS = 16;
+// Hybrid mode: the low SWEEP_BITS positions are not flipped but covered by the window, which
+// then spans exactly 2^SWEEP_BITS keys (RADIUS below the center, RADIUS_PLUS above it).
+bool SWEEP_MODE = false;
+int SWEEP_BITS = 0;
+// --mutable-bits/--fixed-bits narrow the key bits flips may touch to FLIP_MASK (the swept bits
+// are never in it). FLIP_BITS[i] is the key bit of flip position i, so the generators rank and
+// unrank over the allowed positions only.
+__uint128_t MUTABLE_BITS = ~(__uint128_t)0;
+__uint128_t FIXED_BITS = 0;
+__uint128_t FLIP_MASK = 0;
+vector<int> FLIP_BITS;
+// Keys the search may hash, the puzzle interval [2^(n-1), 2^n) narrowed by --key-min/--key-max.
+// Only combinations whose key lies in it are generated, and window keys outside it are passed
+// over; in sweep mode every block of swept keys that reaches into it is searched, clipped to
+// it. High bits that every key of the range shares are taken out of FLIP_MASK: FORCED_FLIPS
+// are the ones flipped in every combination, FORCED_COUNT of them. KEY_RANGE_BINDS when the
+// range still excludes combinations of the positions left, which are then ranked with
+// KEY_RANGE.
+__uint128_t KEY_MIN = 0;
+__uint128_t KEY_MAX = ~(__uint128_t)0;
+__uint128_t FORCED_FLIPS = 0;
+int FORCED_COUNT = 0;
+bool KEY_RANGE_BINDS = false;
+int RADIUS_PLUS = RADIUS;
 
 const unordered_map<int, tuple<int, string, string>> PUZZLE_DATA = {
     {20, {8, "b907c3a2a3b27789dfb509b730dd47703c272868", "357535"}},
@@ -274,10 +447,39 @@ const unordered_map<int, tuple<int, string, string>> PUZZLE_DATA = {
 
 vector<unsigned char> TARGET_HASH160_RAW(20);
 string TARGET_HASH160;
+// Every hash160 searched for: the puzzle's own target plus --targets / --all-puzzles.
+TargetSet TARGETS;
+// Large target lists (--index), mapped read-only and probed alongside TARGETS.
+TargetIndex INDEX;
+// JSONL sink for hits (--results), written under result_mutex.
+ofstream RESULTS_SINK;
 Int BASE_KEY;
+// BASE_KEY with the swept low bits set to the center of the window; flips are applied to it.
+Int FLIP_BASE_KEY;
+// The rank space is a concatenation of segments, one per flip count over the flippable
+// positions; SEGMENT_START[i] is the global rank of the first combination of SEGMENT_FLIPS[i].
+// Segments are ordered cheapest first, by their number of combinations.
+vector<int> SEGMENT_FLIPS;
+vector<__uint128_t> SEGMENT_START;
+// Combinations of every segment in this process's share (shard), for per-flip-count progress;
+// empty for a worker of a coordinator, which only sees its leases.
+vector<__uint128_t> SEGMENT_SHARE;
+// Point added to the current public key when position i enters (IN) or leaves (OUT) the flip
+// set: +/-2^FLIP_BITS[i]*G, with the sign taken from that bit of BASE_KEY. Only used in
+// revolving-door order.
+vector<Point> FLIP_IN_POINTS;
+vector<Point> FLIP_OUT_POINTS;
+// i*G and -i*G for offsets i = 1..RADIUS around every mutated key, shared by all workers.
+// Offsets above the key only go up to RADIUS_PLUS.
+vector<Point> WINDOW_PLUS_POINTS;
+vector<Point> WINDOW_MINUS_POINTS;
 atomic<bool> stop_event(false);
 mutex result_mutex;
-queue<tuple<string, __uint128_t, int, vector<int>>> results;
+// key, keys checked, distance from the base key, flipped bits, target label
+queue<tuple<string, __uint128_t, int, vector<int>, string>> results;
+// Chunks of the ranks left to search; a chunk's position only moves at block boundaries.
+ChunkScheduler SCHEDULER;
+atomic<int> finished_workers(0);
 
 union AVXCounter {
   __m512i vec512;
@@ -343,13 +545,86 @@ union AVXCounter {
   }
 };
 
-static AVXCounter total_checked_avx;
 __uint128_t total_combinations = 0;
-vector<string> g_threadPrivateKeys;
-mutex progress_mutex;
+__uint128_t total_keys = 0;
+
+// The key a thread is working on, published through a seqlock: the hot loop neither allocates
+// nor locks, and the display formats a copy only when it refreshes.
+struct alignas(64) KeySnapshot {
+  atomic<uint32_t> sequence{0};
+  atomic<uint64_t> limbs[4];
+
+  void Publish(const Int& key) {
+    const uint32_t s = sequence.load(memory_order_relaxed);
+    sequence.store(s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (int i = 0; i < 4; i++) limbs[i].store(key.bits64[i], memory_order_relaxed);
+    sequence.store(s + 2, memory_order_release);
+  }
+
+  // Retries while a write is in progress, so the copy is never torn.
+  void Read(uint64_t out[4]) const {
+    uint32_t before, after;
+    do {
+      before = sequence.load(memory_order_acquire);
+      for (int i = 0; i < 4; i++) out[i] = limbs[i].load(memory_order_relaxed);
+      atomic_thread_fence(memory_order_acquire);
+      after = sequence.load(memory_order_relaxed);
+    } while ((before & 1) || before != after);
+  }
+};
+unique_ptr<KeySnapshot[]> g_threadKeys;
+// Threads whose rate and current key are shown with the progress.
+static constexpr int MAX_THREADS_SHOWN = 8;
+// Flip counts whose progress is shown.
+static constexpr int MAX_SEGMENTS_SHOWN = 8;
+
+// Keys hashed by one thread in this run, on a cache line of its own: only that thread writes
+// it, with a plain store, and observers sum all of them. No line bounces between cores.
+struct alignas(64) KeyCounter {
+  atomic<uint64_t> keys{0};
+  // Window keys outside [KEY_MIN, KEY_MAX], passed over unhashed; progress counts them.
+  atomic<uint64_t> skipped{0};
+
+  void Add(uint64_t n) { keys.store(keys.load(memory_order_relaxed) + n, memory_order_relaxed); }
+  void Skip(uint64_t n) {
+    skipped.store(skipped.load(memory_order_relaxed) + n, memory_order_relaxed);
+  }
+};
+unique_ptr<KeyCounter[]> g_threadCounters;
+
+// Time stamp counter ticks one thread spent in each stage of the search loop, kept like
+// KeyCounter. Reading the TSC costs a few cycles, so every block and hash batch is timed.
+enum SearchStage { STAGE_GENERATE, STAGE_INVERT, STAGE_WINDOW, STAGE_HASH, STAGE_COUNT };
+static const char* const STAGE_NAMES[STAGE_COUNT] = {"generate", "invert", "window", "hash"};
+struct alignas(64) StageTicks {
+  atomic<uint64_t> ticks[STAGE_COUNT] = {};
+
+  void Add(SearchStage stage, uint64_t n) {
+    ticks[stage].store(ticks[stage].load(memory_order_relaxed) + n, memory_order_relaxed);
+  }
+};
+unique_ptr<StageTicks[]> g_threadStages;
+// Keys of this search checked by the runs a checkpoint continues.
+__uint128_t CHECKED_BEFORE = 0;
+
+// Keys hashed by all threads of this run.
+static uint64_t keysThisRun() {
+  uint64_t sum = 0;
+  for (int t = 0; t < WORKERS; t++) sum += g_threadCounters[t].keys.load(memory_order_relaxed);
+  return sum;
+}
+
+// Window keys this run passed over for lying outside the key range.
+static uint64_t keysSkippedThisRun() {
+  uint64_t sum = 0;
+  for (int t = 0; t < WORKERS; t++) sum += g_threadCounters[t].skipped.load(memory_order_relaxed);
+  return sum;
+}
+
+// Keys of the search checked so far, earlier runs included.
+static __uint128_t keysChecked() { return CHECKED_BEFORE + keysThisRun(); }
 
-atomic<uint64_t> globalComparedCount(0);
-atomic<uint64_t> localComparedCount(0);
 double globalElapsedTime = 0.0;
 double mkeysPerSec = 0.0;
 chrono::time_point<chrono::high_resolution_clock> tStart;
@@ -364,6 +639,17 @@ static std::string formatElapsedTime(double seconds) {
   return oss.str();
 }
 
+// Formats the limbs of a key the way the solution is shown, e.g. 0x2DE40F.
+static string formatKey(const uint64_t limbs[4]) {
+  char text[2 + 64 + 1];
+  snprintf(text, sizeof(text), "0x%016llX%016llX%016llX%016llX", (unsigned long long)limbs[3],
+           (unsigned long long)limbs[2], (unsigned long long)limbs[1],
+           (unsigned long long)limbs[0]);
+  const char* digits = text + 2;
+  while (*digits == '0' && digits[1] != '\0') digits++;
+  return string("0x") + digits;
+}
+
 static std::string to_string_128(__uint128_t value) {
   if (value == 0) return "0";
   char buffer[50];
@@ -376,12 +662,38 @@ static std::string to_string_128(__uint128_t value) {
   return std::string(p);
 }
 
+// Set by the signal handler; the interrupt is logged once the threads have stopped.
+atomic<bool> interrupted(false);
+
 void signalHandler(int signum) {
   stop_event.store(true);
+  interrupted.store(true);
   cout << "\nInterrupt received, shutting down...\n";
-  if (g_smart_logger) g_smart_logger->logOperation("INTERRUPT", "Signal received");
 }
 
+// Pascal's triangle up to MAX_BINOMIAL_N, built at compile time so ranking and unranking take
+// one lookup per binomial. C(128, 64) < 2^128, so every entry fits; the additions are checked
+// anyway and a table that overflowed would not compile.
+static constexpr int MAX_BINOMIAL_N = 128;
+struct BinomialTable {
+  __uint128_t entries[MAX_BINOMIAL_N + 1][MAX_BINOMIAL_N + 1] = {};
+  bool overflow = false;
+};
+static constexpr BinomialTable makeBinomialTable() {
+  BinomialTable table;
+  for (int n = 0; n <= MAX_BINOMIAL_N; n++) {
+    table.entries[n][0] = 1;
+    for (int k = 1; k <= n; k++) {
+      const __uint128_t sum = table.entries[n - 1][k - 1] + table.entries[n - 1][k];
+      if (sum < table.entries[n - 1][k - 1]) table.overflow = true;
+      table.entries[n][k] = sum;
+    }
+  }
+  return table;
+}
+static constexpr BinomialTable BINOMIALS = makeBinomialTable();
+static_assert(!BINOMIALS.overflow, "C(n, k) for n <= MAX_BINOMIAL_N must fit in 128 bits");
+
 class CombinationGenerator {
   int n, k;
   std::vector<int> current;
@@ -392,17 +704,9 @@ class CombinationGenerator {
     for (int i = 0; i < k; ++i) current[i] = i;
   }
 
-  static __uint128_t combinations_count(int n, int k) {
-    if (k > n) return 0;
-    if (k * 2 > n) k = n - k;
-    if (k == 0) return 1;
-
-    __uint128_t result = n;
-    for (int i = 2; i <= k; ++i) {
-      result *= (n - i + 1);
-      result /= i;
-    }
-    return result;
+  // C(n, k) for 0 <= n <= MAX_BINOMIAL_N; 0 when k is out of range.
+  static constexpr __uint128_t combinations_count(int n, int k) {
+    return k < 0 || k > n ? 0 : BINOMIALS.entries[n][k];
   }
 
   static __m512i combinations_count_avx512(int n, int k) {
@@ -425,8 +729,19 @@ class CombinationGenerator {
     return true;
   }
 
+  // Lexicographic rank of the current combination; the inverse of unrank. In the
+  // combinatorial number system the colex rank of the complements (n - 1 - c_i) is
+  // sum C(n - 1 - c_i, k - i), and lexicographic order reverses it.
+  __uint128_t rank() const {
+    __uint128_t x = 0;
+    for (int i = 0; i < k; i++) x += combinations_count((n - 1) - current[i], k - i);
+    return combinations_count(n, k) - 1 - x;
+  }
+
+  // Jumps to the combination of the given lexicographic rank. a only decreases, so this takes
+  // O(n) table lookups in total.
   void unrank(__uint128_t rank) {
-    __uint128_t total = combinations_count(n, k);
+    const __uint128_t total = combinations_count(n, k);
     if (rank >= total) {
       current.clear();
       return;
@@ -434,366 +749,1531 @@ class CombinationGenerator {
 
     current.resize(k);
     int a = n;
-    int b = k;
     __uint128_t x = (total - 1) - rank;
-    for (int i = 0; i < k; i++) {
-      a = largest_a_where_comb_a_b_le_x(a, b, x);
+    for (int i = 0, b = k; i < k; i++, b--) {
+      while (a >= b && combinations_count(a, b) > x) a--;
       current[i] = (n - 1) - a;
       x -= combinations_count(a, b);
-      b--;
     }
   }
+};
 
- private:
-  int largest_a_where_comb_a_b_le_x(int a, int b, __uint128_t x) const {
-    while (a >= b && combinations_count(a, b) > x) {
-      a--;
+// Highest set bit of a nonzero 128-bit value.
+static inline int highestBit(__uint128_t x) {
+  const uint64_t high = (uint64_t)(x >> 64);
+  return high ? 127 - __builtin_clzll(high) : 63 - __builtin_clzll((uint64_t)x);
+}
+
+// The low bits 0..count-1 set, for count <= 128.
+static inline __uint128_t lowBits(int count) {
+  return count >= 128 ? ~(__uint128_t)0 : ((__uint128_t)1 << count) - 1;
+}
+
+// k-subsets of {0..n-1} (n <= 128) as bit masks, position p being bit p, in the lexicographic
+// order and with the ranks of CombinationGenerator. Scattered onto FLIP_MASK a mask is the XOR
+// that applies the flips to a key, so no position list or per-bit Int is needed. Gosper's hack
+// walks colex order, which would not match the ranks in checkpoints and shards; next() is the
+// lexicographic counterpart, a few branch-free bit operations on the mask.
+class FlipMaskGenerator {
+  int n, k;
+  __uint128_t mask;
+
+ public:
+  FlipMaskGenerator(int n, int k) : n(n), k(k > n ? n : k), mask(lowBits(this->k)) {}
+
+  __uint128_t get() const { return mask; }
+
+  // The tail is the run of positions packed against n - 1. The highest position below it moves
+  // up by one and the tail closes up right behind it. Returns false after the last mask.
+  bool next() {
+    const __uint128_t unused = ~mask & lowBits(n);
+    if (unused == 0) return false;
+    const int gap = highestBit(unused);
+    const __uint128_t below = mask & lowBits(gap);
+    if (below == 0) return false;
+    const int moved = highestBit(below);
+    const int tail = n - 1 - gap;
+    mask = (mask & lowBits(moved)) | (lowBits(tail + 1) << (moved + 1));
+    return true;
+  }
+
+  // Copies the current mask and its successors into masks, at most count of them, and moves
+  // past them; more turns false once the last mask has been taken. Most successors only move
+  // the highest position up by one, and such runs are written 8 masks per AVX-512 step.
+  int take(__uint128_t* masks, int count, bool& more) {
+    more = true;
+    int taken = 0;
+    while (taken < count) {
+      if (k == 0) {
+        masks[taken++] = 0;
+        more = false;
+        break;
+      }
+      const int top = highestBit(mask);
+      const int run = min(count - taken, n - top);
+      const __uint128_t base = mask ^ ((__uint128_t)1 << top);
+      const __m512i one = _mm512_set1_epi64(1);
+      const __m512i baseLow = _mm512_set1_epi64((long long)(uint64_t)base);
+      const __m512i baseHigh = _mm512_set1_epi64((long long)(uint64_t)(base >> 64));
+      for (int j = 0; j < run; j += 8) {
+        // Shifts of 64 or more, and negative ones, give 0 in sllv_epi64.
+        const __m512i position = _mm512_add_epi64(_mm512_set1_epi64(top + j),
+                                                  _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+        alignas(64) uint64_t low[8], high[8];
+        _mm512_store_si512(low, _mm512_or_si512(baseLow, sllv_epi64(one, position)));
+        const __m512i highPosition = _mm512_sub_epi64(position, _mm512_set1_epi64(64));
+        _mm512_store_si512(high, _mm512_or_si512(baseHigh, sllv_epi64(one, highPosition)));
+        for (int lane = 0; lane < 8 && j + lane < run; lane++) {
+          masks[taken + j + lane] = ((__uint128_t)high[lane] << 64) | low[lane];
+        }
+      }
+      taken += run;
+      mask = masks[taken - 1];
+      if (!next()) {
+        more = false;
+        break;
+      }
+    }
+    return taken;
+  }
+
+  // Jumps to the mask of the given lexicographic rank, as CombinationGenerator::unrank does.
+  void unrank(__uint128_t rank) {
+    const __uint128_t total = CombinationGenerator::combinations_count(n, k);
+    mask = 0;
+    if (rank >= total) return;
+    int a = n;
+    __uint128_t x = (total - 1) - rank;
+    for (int i = 0, b = k; i < k; i++, b--) {
+      while (a >= b && CombinationGenerator::combinations_count(a, b) > x) a--;
+      mask |= (__uint128_t)1 << ((n - 1) - a);
+      x -= CombinationGenerator::combinations_count(a, b);
     }
-    return a;
   }
 };
 
-inline void prepareShaBlock(const uint8_t* dataSrc, __uint128_t dataLen, uint8_t* outBlock) {
-  std::fill_n(outBlock, 64, 0);
-  std::memcpy(outBlock, dataSrc, dataLen);
-  outBlock[dataLen] = 0x80;
-  const uint32_t bitLen = (uint32_t)(dataLen * 8);
-  outBlock[60] = (uint8_t)((bitLen >> 24) & 0xFF);
-  outBlock[61] = (uint8_t)((bitLen >> 16) & 0xFF);
-  outBlock[62] = (uint8_t)((bitLen >> 8) & 0xFF);
-  outBlock[63] = (uint8_t)(bitLen & 0xFF);
+// Spreads the positions of a generator mask onto the key bits in FLIP_MASK (BMI2 PDEP), giving
+// the flip mask of the key.
+static inline __uint128_t scatterFlips(__uint128_t positions) {
+  const uint64_t lowMask = (uint64_t)FLIP_MASK;
+  const int lowCount = __builtin_popcountll(lowMask);
+  const uint64_t low = _pdep_u64((uint64_t)positions, lowMask);
+  const uint64_t high = _pdep_u64((uint64_t)(positions >> lowCount), (uint64_t)(FLIP_MASK >> 64));
+  return ((__uint128_t)high << 64) | low;
 }
 
-inline void prepareRipemdBlock(const uint8_t* dataSrc, uint8_t* outBlock) {
-  std::fill_n(outBlock, 64, 0);
-  std::memcpy(outBlock, dataSrc, 32);
-  outBlock[32] = 0x80;
-  const uint32_t bitLen = 256;
-  outBlock[60] = (uint8_t)((bitLen >> 24) & 0xFF);
-  outBlock[61] = (uint8_t)((bitLen >> 16) & 0xFF);
-  outBlock[62] = (uint8_t)((bitLen >> 8) & 0xFF);
-  outBlock[63] = (uint8_t)(bitLen & 0xFF);
+// XORs a flip mask into a key; masks cover the low 128 bits.
+static inline void applyFlipMask(Int& key, __uint128_t mask) {
+  key.bits64[0] ^= (uint64_t)mask;
+  key.bits64[1] ^= (uint64_t)(mask >> 64);
 }
 
-static void computeHash160BatchBinSingle(int numKeys, uint8_t pubKeys[][33],
-                                         uint8_t hashResults[][20]) {
-  alignas(64) std::array<std::array<uint8_t, 64>, HASH_BATCH_SIZE> shaInputs;
-  alignas(64) std::array<std::array<uint8_t, 32>, HASH_BATCH_SIZE> shaOutputs;
-  alignas(64) std::array<std::array<uint8_t, 64>, HASH_BATCH_SIZE> ripemdInputs;
-  alignas(64) std::array<std::array<uint8_t, 20>, HASH_BATCH_SIZE> ripemdOutputs;
+// Positions set in a flip mask, in increasing order.
+static vector<int> maskPositions(__uint128_t mask) {
+  vector<int> positions;
+  for (; mask != 0; mask &= mask - 1) {
+    const uint64_t low = (uint64_t)mask;
+    positions.push_back(low ? __builtin_ctzll(low) : 64 + __builtin_ctzll((uint64_t)(mask >> 64)));
+  }
+  return positions;
+}
 
-  const __uint128_t totalBatches = (numKeys + (HASH_BATCH_SIZE - 1)) / HASH_BATCH_SIZE;
-  for (__uint128_t batch = 0; batch < totalBatches; batch++) {
-    const __uint128_t batchCount =
-        std::min<__uint128_t>(HASH_BATCH_SIZE, numKeys - batch * HASH_BATCH_SIZE);
+// Digit DP that counts flip combinations by the key they produce, for keys confined to
+// [low, high]. Key bits are decided from the most significant one down; level i decides bit
+// lowest + i - 1, so i bits are left to decide before it. The state is whether the bits decided
+// so far still equal those of low (TIGHT_LOW) and of high (TIGHT_HIGH); once a key bit is above
+// low's (below high's) that bound can no longer be crossed. ways(i, j, state) counts the ways
+// to put j flips on the flippable bits among the lowest i levels and stay in range.
+class KeyRangeCounter {
+  int lowest = 0, levels = 0, maxFlips = 0;
+  __uint128_t base = 0, flippable = 0, low = 0, high = 0;
+  vector<__uint128_t> table;
 
-    for (__uint128_t i = 0; i < batchCount; i++) {
-      prepareShaBlock(pubKeys[batch * HASH_BATCH_SIZE + i], 33, shaInputs[i].data());
+ public:
+  static constexpr int TIGHT_LOW = 1, TIGHT_HIGH = 2, TIGHT = TIGHT_LOW | TIGHT_HIGH;
+
+  // Flips apply to the bits of flippable in base; bits below lowest are not compared.
+  void init(__uint128_t base, __uint128_t flippable, __uint128_t low, __uint128_t high,
+            int lowest, int highest) {
+    this->lowest = lowest;
+    levels = highest - lowest + 1;
+    this->base = base;
+    this->flippable = flippable & lowBits(highest + 1) & ~lowBits(lowest);
+    this->low = low;
+    this->high = high;
+    maxFlips = __builtin_popcountll((uint64_t)this->flippable) +
+               __builtin_popcountll((uint64_t)(this->flippable >> 64));
+    table.assign((size_t)(levels + 1) * (maxFlips + 1) * 4, 0);
+    for (int state = 0; state < 4; state++) table[index(0, 0, state)] = 1;
+    for (int i = 1; i <= levels; i++) {
+      for (int j = 0; j <= maxFlips; j++) {
+        for (int state = 0; state < 4; state++) {
+          __uint128_t sum = 0;
+          for (int value = 0; value < 2; value++) {
+            const int flip = flipFor(i, value);
+            const int next = step(i, value, state);
+            if (flip >= 0 && next >= 0) sum += ways(i - 1, j - flip, next);
+          }
+          table[index(i, j, state)] = sum;
+        }
+      }
     }
+  }
+
+  int levelCount() const { return levels; }
+  int bit(int i) const { return lowest + i - 1; }
+
+  __uint128_t ways(int i, int j, int state) const {
+    return j < 0 || j > maxFlips ? 0 : table[index(i, j, state)];
+  }
+  // Combinations of k flips whose key is in range.
+  __uint128_t count(int k) const { return ways(levels, k, TIGHT); }
+
+  // Whether bit(i) has to flip (1) or stay (0) for the key bit to become value; -1 if it
+  // would have to flip but may not.
+  int flipFor(int i, int value) const {
+    const int flip = value ^ (int)((base >> bit(i)) & 1);
+    return flip && !((flippable >> bit(i)) & 1) ? -1 : flip;
+  }
+
+  // The state once bit(i) of the key is value; -1 if that leaves the range.
+  int step(int i, int value, int state) const {
+    const int lowBit = (int)((low >> bit(i)) & 1), highBit = (int)((high >> bit(i)) & 1);
+    if ((state & TIGHT_LOW) && value < lowBit) return -1;
+    if ((state & TIGHT_HIGH) && value > highBit) return -1;
+    return ((state & TIGHT_LOW) && value == lowBit ? TIGHT_LOW : 0) |
+           ((state & TIGHT_HIGH) && value == highBit ? TIGHT_HIGH : 0);
+  }
 
-    if (batchCount < HASH_BATCH_SIZE) {
-      static std::array<uint8_t, 64> shaPadding = {};
-      prepareShaBlock(pubKeys[0], 33, shaPadding.data());
-      for (__uint128_t i = batchCount; i < HASH_BATCH_SIZE; i++) {
-        std::memcpy(shaInputs[i].data(), shaPadding.data(), 64);
+ private:
+  size_t index(int i, int j, int state) const {
+    return ((size_t)i * (maxFlips + 1) + j) * 4 + state;
+  }
+};
+
+KeyRangeCounter KEY_RANGE;
+
+// The k-flip combinations counted by KEY_RANGE, as flip masks over the key bits, in increasing
+// order of their keys. Out-of-range keys are never produced: unrank walks the DP down from the
+// top, skipping whole subtrees by their counts, and next() backs up to the lowest bit whose key
+// value can still go from 0 to 1 and takes the smallest completion below it.
+class RangeMaskGenerator {
+  int k;
+  __uint128_t mask = 0;
+  // Flips still to place and the DP state before level i was decided, for next().
+  vector<int> flipsLeft;
+  vector<int> states;
+
+  // Decides levels i..1 from state, taking the completion of the given rank among them.
+  void descend(int i, int flips, int state, __uint128_t rank) {
+    for (; i >= 1; i--) {
+      flipsLeft[i] = flips;
+      states[i] = state;
+      for (int value = 0; value < 2; value++) {
+        const int flip = KEY_RANGE.flipFor(i, value);
+        const int next = KEY_RANGE.step(i, value, state);
+        if (flip < 0 || next < 0) continue;
+        const __uint128_t ways = KEY_RANGE.ways(i - 1, flips - flip, next);
+        if (rank >= ways) {
+          rank -= ways;
+          continue;
+        }
+        mask |= (__uint128_t)flip << KEY_RANGE.bit(i);
+        flips -= flip;
+        state = next;
+        break;
       }
     }
+  }
 
-    const uint8_t* inPtr[HASH_BATCH_SIZE];
-    uint8_t* outPtr[HASH_BATCH_SIZE];
-    for (int i = 0; i < HASH_BATCH_SIZE; i++) {
-      inPtr[i] = shaInputs[i].data();
-      outPtr[i] = shaOutputs[i].data();
+ public:
+  explicit RangeMaskGenerator(int k)
+      : k(k), flipsLeft(KEY_RANGE.levelCount() + 1), states(KEY_RANGE.levelCount() + 1) {
+    unrank(0);
+  }
+
+  __uint128_t get() const { return mask; }
+
+  bool next() {
+    for (int i = 1; i <= KEY_RANGE.levelCount(); i++) {
+      const int bit = KEY_RANGE.bit(i);
+      // Only a key bit that is 0 now can move on to 1.
+      if (KEY_RANGE.flipFor(i, 1) == (int)((mask >> bit) & 1)) continue;
+      const int flip = KEY_RANGE.flipFor(i, 1);
+      const int next = KEY_RANGE.step(i, 1, states[i]);
+      if (flip < 0 || next < 0 || KEY_RANGE.ways(i - 1, flipsLeft[i] - flip, next) == 0) {
+        continue;
+      }
+      mask = (mask & ~lowBits(bit + 1)) | ((__uint128_t)flip << bit);
+      descend(i - 1, flipsLeft[i] - flip, next, 0);
+      return true;
+    }
+    return false;
+  }
+
+  // Same contract as FlipMaskGenerator::take, one mask at a time.
+  int take(__uint128_t* masks, int count, bool& more) {
+    more = true;
+    int taken = 0;
+    while (taken < count) {
+      masks[taken++] = mask;
+      if (!next()) {
+        more = false;
+        break;
+      }
     }
+    return taken;
+  }
+
+  void unrank(__uint128_t rank) {
+    mask = 0;
+    if (rank >= KEY_RANGE.count(k)) return;
+    descend(KEY_RANGE.levelCount(), k, KeyRangeCounter::TIGHT, rank);
+  }
+};
 
-    sha256avx512_16B(inPtr, outPtr);
+// Revolving-door (Gray) order of k-subsets of {0..n-1}: Knuth TAOCP 7.2.1.3, Algorithm R.
+// Consecutive combinations differ by exactly one position entering and one leaving, so the
+// mutated key changes by +/-2^in and +/-2^out and its public key can be updated with two
+// point additions instead of a full scalar multiplication.
+//
+// The order is Gamma(n,k) = Gamma(n-1,k), reverse(Gamma(n-1,k-1)) + {n-1}, which gives
+//   rank(c_1 < ... < c_k) = sum_{i=1..k} (-1)^(k-i) * (C(c_i + 1, i) - 1)
+class RevolvingDoorGenerator {
+  int n, k;
+  std::vector<int> current;
+
+ public:
+  RevolvingDoorGenerator(int n, int k) : n(n), k(k > n ? n : k), current(this->k) {
+    for (int i = 0; i < this->k; ++i) current[i] = i;
+  }
+
+  const std::vector<int>& get() const { return current; }
+
+  // Advances to the next combination and reports the position that entered and the one that
+  // left. Returns false once the last combination has been visited.
+  bool next(int& in, int& out) {
+    if (k == 0 || k == n) return false;
 
-    for (__uint128_t i = 0; i < batchCount; i++) {
-      prepareRipemdBlock(shaOutputs[i].data(), ripemdInputs[i].data());
+    if (k == 1) {
+      if (current[0] + 1 >= n) return false;
+      out = current[0];
+      in = ++current[0];
+      return true;
     }
 
-    if (batchCount < HASH_BATCH_SIZE) {
-      static std::array<uint8_t, 64> ripemdPadding = {};
-      prepareRipemdBlock(shaOutputs[0].data(), ripemdPadding.data());
-      for (__uint128_t i = batchCount; i < HASH_BATCH_SIZE; i++) {
-        std::memcpy(ripemdInputs[i].data(), ripemdPadding.data(), 64);
+    // c(j) is Knuth's 1-based c_j; c_{k+1} is the sentinel n.
+    auto c = [this](int j) -> int { return j <= k ? current[j - 1] : n; };
+
+    int j = 2;
+    bool tryIncrease;
+    if (k & 1) {
+      if (current[0] + 1 < current[1]) {
+        out = current[0];
+        in = ++current[0];
+        return true;
+      }
+      tryIncrease = false;
+    } else {
+      if (current[0] > 0) {
+        out = current[0];
+        in = --current[0];
+        return true;
       }
+      tryIncrease = true;
     }
 
-    for (int i = 0; i < HASH_BATCH_SIZE; i++) {
-      inPtr[i] = ripemdInputs[i].data();
-      outPtr[i] = ripemdOutputs[i].data();
+    while (j <= k) {
+      if (!tryIncrease) {
+        // R4: c_j == c_{j-1} + 1, try to decrease c_j
+        if (c(j) >= j) {
+          out = current[j - 1];
+          in = j - 2;
+          current[j - 1] = current[j - 2];
+          current[j - 2] = j - 2;
+          return true;
+        }
+        j++;
+        if (j > k) break;
+      }
+      // R5: c_{j-1} == j - 2, try to increase c_j
+      if (c(j) + 1 < c(j + 1)) {
+        out = current[j - 2];
+        in = current[j - 1] + 1;
+        current[j - 2] = current[j - 1];
+        current[j - 1]++;
+        return true;
+      }
+      j++;
+      tryIncrease = false;
     }
+    return false;
+  }
+
+  __uint128_t rank() const {
+    __uint128_t r = 0;
+    for (int i = 1; i <= k; i++) {
+      r = CombinationGenerator::combinations_count(current[i - 1] + 1, i) - 1 - r;
+    }
+    return r;
+  }
+
+  void unrank(__uint128_t rank) {
+    if (rank >= CombinationGenerator::combinations_count(n, k)) {
+      current.clear();
+      return;
+    }
+
+    current.resize(k);
+    // c_i is the largest a with C(a, i) <= rank. It lies below c_{i+1}, so the search walks
+    // down from there and the whole unrank takes O(n) table lookups.
+    int a = n - 1;
+    for (int i = k; i >= 1; i--) {
+      while (CombinationGenerator::combinations_count(a, i) > rank) a--;
+      current[i - 1] = a;
+      rank = CombinationGenerator::combinations_count(a + 1, i) - 1 - rank;
+      a--;
+    }
+  }
+};
+
+// Flips a combination of the segment places on FLIP_BITS, besides the forced ones.
+static int freeFlips(int segment) { return SEGMENT_FLIPS[segment] - FORCED_COUNT; }
+
+static __uint128_t segmentEnd(int segment) {
+  return segment + 1 < (int)SEGMENT_START.size() ? SEGMENT_START[segment + 1] : total_combinations;
+}
+
+// Combinations of every segment that lie in ranges (from position on).
+static vector<__uint128_t> segmentCombinations(const vector<RankRange>& ranges) {
+  vector<__uint128_t> counts(SEGMENT_FLIPS.size(), 0);
+  for (const RankRange& range : ranges) {
+    for (int segment = 0; segment < (int)SEGMENT_FLIPS.size(); segment++) {
+      const __uint128_t first = max(range.position, SEGMENT_START[segment]);
+      const __uint128_t last = min(range.end, segmentEnd(segment));
+      if (first < last) counts[segment] += last - first;
+    }
+  }
+  return counts;
+}
+
+static int locateSegment(__uint128_t rank) {
+  int segment = 0;
+  while (segment + 1 < (int)SEGMENT_START.size() && SEGMENT_START[segment + 1] <= rank) {
+    segment++;
+  }
+  return segment;
+}
+
+// Checks the 16-lane SHA-256, RIPEMD-160 and fused hash160 kernels against the scalar
+// references on fixed inputs.
+static bool verifyHashKernels() {
+  alignas(64) uint8_t inputs[HASH_BATCH_SIZE][33];
+  alignas(64) uint8_t shaOutputs[HASH_BATCH_SIZE][32];
+  alignas(64) uint8_t outputs[HASH_BATCH_SIZE][20];
+  uint8_t expected[32];
+  const uint8_t* inPtr[HASH_BATCH_SIZE];
+  uint8_t* outPtr[HASH_BATCH_SIZE];
+
+  uint32_t state = 0x9E3779B9;
+  for (int i = 0; i < HASH_BATCH_SIZE; i++) {
+    for (int j = 0; j < 33; j++) {
+      state = state * 1664525 + 1013904223;
+      inputs[i][j] = (uint8_t)(state >> 24);
+    }
+    inPtr[i] = inputs[i];
+    outPtr[i] = shaOutputs[i];
+  }
+
+  sha256avx512_16_33(inPtr, outPtr);
+  for (int i = 0; i < HASH_BATCH_SIZE; i++) {
+    sha256_33(inputs[i], expected);
+    if (std::memcmp(expected, shaOutputs[i], 32) != 0) return false;
+    inPtr[i] = shaOutputs[i];
+    outPtr[i] = outputs[i];
+  }
+
+  ripemd160avx512::ripemd160avx512_16(inPtr, outPtr);
+  for (int i = 0; i < HASH_BATCH_SIZE; i++) {
+    ripemd160avx512::ripemd160_32(shaOutputs[i], expected);
+    if (std::memcmp(expected, outputs[i], 20) != 0) return false;
+  }
 
-    ripemd160avx512::ripemd160avx512_16(inPtr, outPtr);
+  // The fused kernel has to agree with the two separate ones.
+  for (int i = 0; i < HASH_BATCH_SIZE; i++) inPtr[i] = inputs[i];
+  __m512i hashWords[5];
+  hash160avx512_16(inPtr, hashWords);
+  for (int i = 0; i < HASH_BATCH_SIZE; i++) {
+    hash160avx512_lane(hashWords, i, expected);
+    if (std::memcmp(expected, outputs[i], 20) != 0) return false;
+  }
 
-    for (__uint128_t i = 0; i < batchCount; i++) {
-      std::memcpy(hashResults[batch * HASH_BATCH_SIZE + i], ripemdOutputs[i].data(), 20);
+  // So does the path that serialises keys from x limbs and y parity in registers.
+  alignas(64) uint64_t x[HASH_BATCH_SIZE][4];
+  alignas(64) uint32_t yOdd[HASH_BATCH_SIZE];
+  const uint64_t* xPtr[HASH_BATCH_SIZE];
+  for (int i = 0; i < HASH_BATCH_SIZE; i++) {
+    inputs[i][0] = 0x02 | (inputs[i][0] & 1);
+    yOdd[i] = inputs[i][0] & 1;
+    for (int j = 0; j < 32; j++) {
+      ((uint8_t*)x[i])[j] = inputs[i][32 - j];
     }
+    xPtr[i] = x[i];
+    inPtr[i] = inputs[i];
+  }
+  __m512i message[9], packedWords[5];
+  hash160avx512_message(xPtr, yOdd, message);
+  hash160avx512_16(message, packedWords);
+  hash160avx512_16(inPtr, hashWords);
+  for (int w = 0; w < 5; w++) {
+    if (_mm512_cmpneq_epi32_mask(packedWords[w], hashWords[w]) != 0) return false;
   }
+  return true;
 }
 
-// NAJWAŻNIEJSZA CZĘŚĆ: poprawny algorytm mutacji (AVX2-style logic)
-void worker(Secp256K1* secp, int bit_length, int flip_count, int threadId, AVXCounter start,
-            AVXCounter end) {
+// Working memory of searchRange, allocated once per thread so that searching a chunk does not
+// touch the heap.
+struct SearchScratch {
+  // The start points of a block of COMBINATION_BATCH_SIZE combinations are derived in
+  // projective form and normalised with one shared inversion; their neighbourhoods then share
+  // a second one.
+  vector<Int> deltaX;
+  IntGroup modGroup;
+  vector<Int> startZ;
+  IntGroup startGroup;
+  vector<Point> blockPoints;
+  vector<Int> blockKeys;
+  // Flips of every combination of the block, as a mask over the key's bits.
+  vector<__uint128_t> blockMasks;
+  vector<Int> pointBatchX;
+  vector<Int> pointBatchY;
+
+  explicit SearchScratch(int keysPerCombination)
+      : deltaX(max(COMBINATION_BATCH_SIZE * RADIUS, 1)),
+        modGroup(COMBINATION_BATCH_SIZE * RADIUS),
+        startZ(COMBINATION_BATCH_SIZE),
+        startGroup(COMBINATION_BATCH_SIZE),
+        blockPoints(COMBINATION_BATCH_SIZE),
+        blockKeys(COMBINATION_BATCH_SIZE),
+        blockMasks(COMBINATION_BATCH_SIZE),
+        pointBatchX(keysPerCombination),
+        pointBatchY(keysPerCombination) {}
+};
+
+// The mutation search proper: checks every key of the combinations from range.position to
+// range.end, a block of COMBINATION_BATCH_SIZE at a time, and records progress in SCHEDULER.
+static void searchRange(Secp256K1* secp, int bit_length, int threadId, const RankRange& range,
+                        SearchScratch& scratch) {
+  AVXCounter start, end;
+  start.store(range.position);
+  end.store(range.end);
+  if (start >= end) return;
+
   if (g_smart_logger) {
     g_smart_logger->logAlgorithmStep(
         "WORKER_START", "Thread " + std::to_string(threadId) + " starts processing combinations " +
                             to_string_128(start.load()) + " to " + to_string_128(end.load()));
   }
 
-  const int fullBatchSize = 2 * POINTS_BATCH_SIZE;
-  alignas(64) uint8_t localPubKeys[HASH_BATCH_SIZE][33];
-  alignas(64) uint8_t localHashResults[HASH_BATCH_SIZE][20];
+  // Neighbourhood of every mutated key: index 0 is the key itself, 1..RADIUS_PLUS are
+  // key+1..key+RADIUS_PLUS and the RADIUS entries after them are key-1..key-RADIUS.
+  const int keysPerCombination = 1 + RADIUS_PLUS + RADIUS;
+  // x limbs and y parity of the pending lanes; the hash kernel serialises them itself.
+  alignas(64) uint64_t laneX[HASH_BATCH_SIZE][4];
+  alignas(64) uint32_t laneYOdd[HASH_BATCH_SIZE];
   alignas(64) int pointIndices[HASH_BATCH_SIZE];
+  alignas(64) int pointCombinations[HASH_BATCH_SIZE];
+
+  vector<Int>& deltaX = scratch.deltaX;
+  IntGroup& modGroup = scratch.modGroup;
+  vector<Int>& startZ = scratch.startZ;
+  IntGroup& startGroup = scratch.startGroup;
+  vector<Point>& blockPoints = scratch.blockPoints;
+  vector<Int>& blockKeys = scratch.blockKeys;
+  vector<__uint128_t>& blockMasks = scratch.blockMasks;
+  vector<Int>& pointBatchX = scratch.pointBatchX;
+  vector<Int>& pointBatchY = scratch.pointBatchY;
+
+  int segment = locateSegment(start.load());
+  const __uint128_t segmentRank = start.load() - SEGMENT_START[segment];
+  FlipMaskGenerator maskGen(bit_length, freeFlips(segment));
+  RevolvingDoorGenerator grayGen(bit_length, freeFlips(segment));
+  RangeMaskGenerator rangeGen(freeFlips(segment));
+  if (GRAY_ORDER) {
+    grayGen.unrank(segmentRank);
+  } else if (KEY_RANGE_BINDS) {
+    rangeGen.unrank(segmentRank);
+  } else {
+    maskGen.unrank(segmentRank);
+  }
 
-  alignas(64) Point plusPoints[POINTS_BATCH_SIZE];
-  alignas(64) Point minusPoints[POINTS_BATCH_SIZE];
+  AVXCounter count;
+  count.store(start.load());
+  AVXCounter gathered;
+  gathered.store(start.load());
+  bool exhausted = false;
+
+  KeyCounter& counter = g_threadCounters[threadId];
+  StageTicks& stages = g_threadStages[threadId];
+
+  // Revolving-door order only: the next key, its public key and its flip mask.
+  Int nextKey;
+  Point nextPoint;
+  __uint128_t grayMask = 0;
+  bool freshStart = true;
+
+  // Every combination below count has had all its keys hashed.
+  auto savePosition = [&]() { SCHEDULER.Advance(threadId, count.load()); };
+
+  // Moves on to the first combination of the next flip count once a segment is done.
+  auto nextSegment = [&]() -> bool {
+    if (segment + 1 >= (int)SEGMENT_FLIPS.size()) return false;
+    segment++;
+    maskGen = FlipMaskGenerator(bit_length, freeFlips(segment));
+    grayGen = RevolvingDoorGenerator(bit_length, freeFlips(segment));
+    rangeGen = RangeMaskGenerator(freeFlips(segment));
+    freshStart = true;
+    return true;
+  };
 
-#pragma omp simd aligned(plusPoints, minusPoints : 64)
-  for (int i = 0; i < POINTS_BATCH_SIZE; i++) {
-    Int tmp;
-    tmp.SetInt32(i);
-    plusPoints[i] = secp->ComputePublicKey(&tmp);
-    minusPoints[i] = plusPoints[i];
-    minusPoints[i].y.ModNeg();
-  }
+  // Key 0 (all flips undo BASE_KEY) has no public key; it is carried as infinity (z == 0).
+  auto publicKeyOf = [&](Int& key) {
+    Point p;
+    if (key.IsZero()) {
+      p.Clear();
+    } else {
+      p = secp->ComputePublicKey(&key, false);
+    }
+    return p;
+  };
 
-  alignas(64) Int deltaX[POINTS_BATCH_SIZE];
-  IntGroup modGroup(POINTS_BATCH_SIZE);
-  alignas(64) Int pointBatchX[fullBatchSize];
-  alignas(64) Int pointBatchY[fullBatchSize];
+  int localBatchCount = 0;
 
-  CombinationGenerator gen(bit_length, flip_count);
-  gen.unrank(start.load());
+  // Hashes the pending lanes (a full batch, or the tail of a block) and compares them against
+  // the target. Returns false once the search has to stop.
+  auto flushHashBatch = [&]() -> bool {
+    if (localBatchCount == 0) return true;
+    const uint64_t hashStart = __rdtsc();
+    const int batchCount = localBatchCount;
+    localBatchCount = 0;
 
-  AVXCounter count;
-  count.store(start.load());
+    // Unused lanes of a partial batch repeat the first key.
+    const uint64_t* xPtr[HASH_BATCH_SIZE];
+    for (int i = 0; i < HASH_BATCH_SIZE; i++) {
+      const int lane = i < batchCount ? i : 0;
+      xPtr[i] = laneX[lane];
+      laneYOdd[i] = laneYOdd[lane];
+    }
+    __m512i message[9];
+    hash160avx512_message(xPtr, laneYOdd, message);
+    __m512i hashWords[5];
+    hash160avx512_16(message, hashWords);
+
+    counter.Add(batchCount);
+
+    // The target filter screens the whole batch at once; lanes that pass are confirmed exactly.
+    const __mmask16 activeLanes = (__mmask16)((1u << batchCount) - 1);
+    __mmask16 matches = TARGETS.Probe(hashWords) & activeLanes;
+    uint32_t indexHits[HASH_BATCH_SIZE];
+    const __mmask16 indexMatches =
+        INDEX.Confirm(hashWords, INDEX.Probe(hashWords) & activeLanes, indexHits);
+    matches |= indexMatches;
+    stages.Add(STAGE_HASH, __rdtsc() - hashStart);
+
+    while (matches) {
+      const int j = __builtin_ctz(matches);
+      matches &= matches - 1;
+
+      uint8_t foundHash[20];
+      hash160avx512_lane(hashWords, j, foundHash);
+      string label;
+      const int targetIndex = TARGETS.Find(foundHash);
+      if (targetIndex >= 0) {
+        label = TARGETS.Get(targetIndex).label;
+      } else if ((indexMatches >> j) & 1) {
+        label = "index #" + to_string(indexHits[j]);
+      } else {
+        continue;
+      }
+
+      const int b = pointCombinations[j];
+      const vector<int> flips = maskPositions(blockMasks[b]);
+      Int foundKey;
+      foundKey.Set(&blockKeys[b]);
+      int idx = pointIndices[j];
+      if (idx > RADIUS_PLUS) {
+        Int offset;
+        offset.SetInt32(idx - RADIUS_PLUS);
+        foundKey.Sub(&offset);
+      } else if (idx > 0) {
+        Int offset;
+        offset.SetInt32(idx);
+        foundKey.Add(&offset);
+      }
+
+      string hexKey = foundKey.GetBase16();
+      hexKey = string(64 - hexKey.length(), '0') + hexKey;
+
+      // With a window (and in sweep mode) the key may differ from the base in other bits than
+      // the flipped ones, so report the real distance.
+      int distance = 0;
+      for (int w = 0; w < 4; w++) {
+        distance += __builtin_popcountll(foundKey.bits64[w] ^ BASE_KEY.bits64[w]);
+      }
+
+      // Convert hash to hex for logging
+      std::ostringstream hashHex;
+      hashHex << std::hex << std::setfill('0');
+      for (int k = 0; k < 20; k++) {
+        hashHex << std::setw(2) << (int)foundHash[k];
+      }
 
-  uint64_t actual_work_done = 0;
+      // LOG SOLUTION WITH ANALYSIS
+      if (g_smart_logger) {
+        g_smart_logger->logSolutionAnalysis(hexKey, hashHex.str(), keysChecked(), flips);
+      }
+
+      {
+        lock_guard<mutex> lock(result_mutex);
+        results.push(make_tuple(hexKey, keysChecked(), distance, flips, label));
+        if (RESULTS_SINK.is_open()) {
+          RESULTS_SINK << "{\"key\":\"" << hexKey << "\",\"hash160\":\"" << hashHex.str()
+                       << "\",\"target\":\"" << label << "\",\"distance\":" << distance
+                       << ",\"flips\":[";
+          for (size_t f = 0; f < flips.size(); f++) {
+            RESULTS_SINK << (f ? "," : "") << flips[f];
+          }
+          RESULTS_SINK << "],\"checked\":\"" << to_string_128(keysChecked())
+                       << "\"}" << endl;
+        }
+      }
+      if (!CONTINUE_ON_MATCH) {
+        stop_event.store(true);
+        return false;
+      }
+    }
+    return true;
+  };
 
   while (!stop_event.load() && count < end) {
-    Int currentKey;
-    currentKey.Set(&BASE_KEY);
+    savePosition();
+    const uint64_t blockStart = __rdtsc();
+    int blockSize = 0;
+    if (GRAY_ORDER) {
+      while (blockSize < COMBINATION_BATCH_SIZE && !exhausted && gathered < end) {
+        // Only the first combination of the range (or of a segment) needs the full key and a
+        // scalar multiplication; later ones are updated incrementally below.
+        if (freshStart) {
+          grayMask = FORCED_FLIPS;
+          for (int pos : grayGen.get()) grayMask |= (__uint128_t)1 << FLIP_BITS[pos];
+          nextKey.Set(&FLIP_BASE_KEY);
+          applyFlipMask(nextKey, grayMask);
+          nextPoint = publicKeyOf(nextKey);
+          freshStart = false;
+        }
 
-    const vector<int>& flips = gen.get();
+        // LOG COMBINATION GENERATION
+        if (g_smart_logger) {
+          g_smart_logger->logCombinationGeneration(threadId, gathered.load(), grayMask);
+        }
 
-    // LOG COMBINATION GENERATION
-    if (g_smart_logger) {
-      g_smart_logger->logCombinationGeneration(threadId, count.load(), flips);
+        blockMasks[blockSize] = grayMask;
+        blockKeys[blockSize].Set(&nextKey);
+        blockPoints[blockSize] = nextPoint;
+        blockSize++;
+
+        gathered.increment();
+        if (gathered >= end) break;
+
+        int in, out;
+        if (!grayGen.next(in, out)) {
+          if (!nextSegment()) exhausted = true;
+          continue;
+        }
+        grayMask ^= ((__uint128_t)1 << FLIP_BITS[in]) | ((__uint128_t)1 << FLIP_BITS[out]);
+        nextKey.SwapBit(FLIP_BITS[in]);
+        nextKey.SwapBit(FLIP_BITS[out]);
+        // The mixed addition covers neither doubling nor the point at infinity (z == 0 on
+        // either side); those steps are recomputed from the scalar.
+        if (!nextPoint.z.IsZero())
+          nextPoint = secp->AddAffine(nextPoint, FLIP_IN_POINTS[in].x, FLIP_IN_POINTS[in].y);
+        if (!nextPoint.z.IsZero())
+          nextPoint = secp->AddAffine(nextPoint, FLIP_OUT_POINTS[out].x, FLIP_OUT_POINTS[out].y);
+        if (nextPoint.z.IsZero()) nextPoint = publicKeyOf(nextKey);
+      }
+    } else {
+      // Lexicographic order (key order within a binding key range): the block's masks come from
+      // the generator in one batch, and every key is FLIP_BASE_KEY with its mask XORed in,
+      // followed by a scalar multiplication.
+      while (blockSize < COMBINATION_BATCH_SIZE && !exhausted && gathered < end) {
+        const int wanted = (int)min<__uint128_t>(COMBINATION_BATCH_SIZE - blockSize,
+                                                 end.load() - gathered.load());
+        bool more;
+        const int taken = KEY_RANGE_BINDS ? rangeGen.take(&blockMasks[blockSize], wanted, more)
+                                          : maskGen.take(&blockMasks[blockSize], wanted, more);
+        for (int b = blockSize; b < blockSize + taken; b++) {
+          // Range masks are over the key bits already.
+          if (!KEY_RANGE_BINDS) blockMasks[b] = scatterFlips(blockMasks[b]);
+          blockMasks[b] |= FORCED_FLIPS;
+          // LOG COMBINATION GENERATION
+          if (g_smart_logger) {
+            g_smart_logger->logCombinationGeneration(
+                threadId, (uint64_t)(gathered.load() + (b - blockSize)), blockMasks[b]);
+          }
+          blockKeys[b].Set(&FLIP_BASE_KEY);
+          applyFlipMask(blockKeys[b], blockMasks[b]);
+          blockPoints[b] = publicKeyOf(blockKeys[b]);
+        }
+        blockSize += taken;
+        gathered.add(taken);
+        if (!more && !nextSegment()) exhausted = true;
+      }
     }
 
-    for (int pos : flips) {
-      Int mask;
-      mask.SetInt32(1);
-      mask.ShiftL(pos);
-      currentKey.Xor(&mask);
+    if (blockSize == 0) break;
+    const uint64_t generated = __rdtsc();
+    stages.Add(STAGE_GENERATE, generated - blockStart);
+
+    for (int b = 0; b < COMBINATION_BATCH_SIZE; b++) {
+      if (b < blockSize && !blockPoints[b].z.IsZero()) {
+        startZ[b].Set(&blockPoints[b].z);
+      } else {
+        startZ[b].SetInt32(1);
+      }
     }
+    startGroup.Set(startZ.data());
+    startGroup.ModInv();
 
-    string keyStr = currentKey.GetBase16();
-    keyStr = string(64 - keyStr.length(), '0') + keyStr;
+    for (int b = 0; b < blockSize; b++) {
+      blockPoints[b].x.ModMulK1(&startZ[b]);
+      blockPoints[b].y.ModMulK1(&startZ[b]);
+      blockPoints[b].z.SetInt32(1);
+    }
 
-    // LOG KEY MUTATION DETAILS (first 10, then every 10000th)
-    if (g_smart_logger && (count.load() < 10 || count.load() % 10000 == 0)) {
-      string baseKeyStr = BASE_KEY.GetBase16();
-      baseKeyStr = string(64 - baseKeyStr.length(), '0') + baseKeyStr;
-      g_smart_logger->logKeyMutationStrategy(threadId, baseKeyStr, flips, keyStr, count.load());
+    if (RADIUS > 0) {
+      for (int b = 0; b < COMBINATION_BATCH_SIZE; b++) {
+        Int* blockDeltaX = &deltaX[b * RADIUS];
+        for (int i = 0; i < RADIUS; i++) {
+          if (b < blockSize) {
+            blockDeltaX[i].ModSub(&WINDOW_PLUS_POINTS[i].x, &blockPoints[b].x);
+            // Center within RADIUS of 0 or n: keep one zero from spoiling the whole inversion.
+            if (blockDeltaX[i].IsZero()) blockDeltaX[i].SetInt32(1);
+          } else {
+            blockDeltaX[i].SetInt32(1);
+          }
+        }
+      }
+      modGroup.Set(deltaX.data());
+      modGroup.ModInv();
     }
+    const uint64_t inverted = __rdtsc();
+    stages.Add(STAGE_INVERT, inverted - generated);
+    // Hash batches flushed while the window is walked are timed on their own.
+    const uint64_t hashedBefore = stages.ticks[STAGE_HASH].load(memory_order_relaxed);
+
+    for (int b = 0; b < blockSize && !stop_event.load(); b++) {
+      Int& currentKey = blockKeys[b];
+      Point& startPoint = blockPoints[b];
+      Int* blockDeltaX = &deltaX[b * RADIUS];
+
+      g_threadKeys[threadId].Publish(currentKey);
+
+      // The window stops at the ends of the key range. A swept block at either end of it may
+      // start outside the range, the key itself included: the first plusSkip (minusSkip) points
+      // of that side are then computed but not hashed.
+      const __uint128_t center = ((__uint128_t)currentKey.bits64[1] << 64) | currentKey.bits64[0];
+      const bool centerInRange = center >= KEY_MIN && center <= KEY_MAX;
+      const int plusCount =
+          center > KEY_MAX ? 0 : (int)min<__uint128_t>(RADIUS_PLUS, KEY_MAX - center);
+      const int plusSkip =
+          center < KEY_MIN ? (int)min<__uint128_t>(plusCount, KEY_MIN - center - 1) : 0;
+      const int minusCount =
+          center < KEY_MIN ? 0 : (int)min<__uint128_t>(RADIUS, center - KEY_MIN);
+      const int minusSkip =
+          center > KEY_MAX ? (int)min<__uint128_t>(minusCount, center - KEY_MAX - 1) : 0;
+      counter.Skip(!centerInRange + (RADIUS_PLUS - plusCount + plusSkip) +
+                   (RADIUS - minusCount + minusSkip));
+
+      // LOG KEY MUTATION DETAILS (first 10, then every 10000th)
+      if (g_smart_logger) {
+        g_smart_logger->logKeyMutationStrategy(threadId, BASE_KEY, blockMasks[b], currentKey,
+                                               (uint64_t)count.load());
+      }
 
-#pragma omp critical
-    { g_threadPrivateKeys[threadId] = keyStr; }
+      Int startPointX, startPointY, startPointXNeg;
+      startPointX.Set(&startPoint.x);
+      startPointY.Set(&startPoint.y);
+      startPointXNeg.Set(&startPointX);
+      startPointXNeg.ModNeg();
 
-    Point startPoint = secp->ComputePublicKey(&currentKey);
-    Int startPointX, startPointY, startPointXNeg;
-    startPointX.Set(&startPoint.x);
-    startPointY.Set(&startPoint.y);
-    startPointXNeg.Set(&startPointX);
-    startPointXNeg.ModNeg();
+      pointBatchX[0].Set(&startPointX);
+      pointBatchY[0].Set(&startPointY);
 
-#pragma omp simd aligned(deltaX, plusPoints : 64)
-    for (int i = 0; i < POINTS_BATCH_SIZE; i++) {
-      deltaX[i].ModSub(&plusPoints[i].x, &startPointX);
-    }
-    modGroup.Set(deltaX);
-    modGroup.ModInv();
+#pragma omp simd
+      for (int i = 0; i < plusCount; i++) {
+        Int deltaY;
+        deltaY.ModSub(&WINDOW_PLUS_POINTS[i].y, &startPointY);
+
+        Int slope;
+        slope.ModMulK1(&deltaY, &blockDeltaX[i]);
 
-#pragma omp simd aligned(pointBatchX, pointBatchY, plusPoints : 64)
-    for (int i = 0; i < POINTS_BATCH_SIZE; i++) {
-      Int deltaY;
-      deltaY.ModSub(&plusPoints[i].y, &startPointY);
+        Int slopeSq;
+        slopeSq.ModSquareK1(&slope);
 
-      Int slope;
-      slope.ModMulK1(&deltaY, &deltaX[i]);
+        pointBatchX[1 + i].Set(&startPointXNeg);
+        pointBatchX[1 + i].ModAdd(&slopeSq);
+        pointBatchX[1 + i].ModSub(&WINDOW_PLUS_POINTS[i].x);
 
-      Int slopeSq;
-      slopeSq.ModSquareK1(&slope);
+        Int diffX;
+        diffX.Set(&startPointX);
+        diffX.ModSub(&pointBatchX[1 + i]);
+        diffX.ModMulK1(&slope);
+
+        pointBatchY[1 + i].Set(&startPointY);
+        pointBatchY[1 + i].ModNeg();
+        pointBatchY[1 + i].ModAdd(&diffX);
+      }
 
-      pointBatchX[i].Set(&startPointXNeg);
-      pointBatchX[i].ModAdd(&slopeSq);
-      pointBatchX[i].ModSub(&plusPoints[i].x);
+#pragma omp simd
+      for (int i = 0; i < minusCount; i++) {
+        Int deltaY;
+        deltaY.ModSub(&WINDOW_MINUS_POINTS[i].y, &startPointY);
 
-      Int diffX;
-      diffX.Set(&startPointX);
-      diffX.ModSub(&pointBatchX[i]);
-      diffX.ModMulK1(&slope);
+        Int slope;
+        slope.ModMulK1(&deltaY, &blockDeltaX[i]);
+
+        Int slopeSq;
+        slopeSq.ModSquareK1(&slope);
+
+        pointBatchX[1 + RADIUS_PLUS + i].Set(&startPointXNeg);
+        pointBatchX[1 + RADIUS_PLUS + i].ModAdd(&slopeSq);
+        pointBatchX[1 + RADIUS_PLUS + i].ModSub(&WINDOW_MINUS_POINTS[i].x);
+
+        Int diffX;
+        diffX.Set(&startPointX);
+        diffX.ModSub(&pointBatchX[1 + RADIUS_PLUS + i]);
+        diffX.ModMulK1(&slope);
+
+        pointBatchY[1 + RADIUS_PLUS + i].Set(&startPointY);
+        pointBatchY[1 + RADIUS_PLUS + i].ModNeg();
+        pointBatchY[1 + RADIUS_PLUS + i].ModAdd(&diffX);
+      }
+
+      for (int i = 0; i < keysPerCombination; i++) {
+        const bool inRange = i == 0             ? centerInRange
+                             : i <= RADIUS_PLUS ? i > plusSkip && i <= plusCount
+                                                : i - RADIUS_PLUS > minusSkip &&
+                                                      i - RADIUS_PLUS <= minusCount;
+        if (!inRange) continue;
+        std::memcpy(laneX[localBatchCount], pointBatchX[i].bits64, sizeof(laneX[0]));
+        laneYOdd[localBatchCount] = (uint32_t)(pointBatchY[i].bits64[0] & 1);
+        pointIndices[localBatchCount] = i;
+        pointCombinations[localBatchCount] = b;
+        localBatchCount++;
+
+        if (localBatchCount == HASH_BATCH_SIZE && !flushHashBatch()) {
+          savePosition();
+          return;
+        }
+      }
 
-      pointBatchY[i].Set(&startPointY);
-      pointBatchY[i].ModNeg();
-      pointBatchY[i].ModAdd(&diffX);
+      count.increment();
     }
 
-#pragma omp simd aligned(pointBatchX, pointBatchY, minusPoints : 64)
-    for (int i = 0; i < POINTS_BATCH_SIZE; i++) {
-      Int deltaY;
-      deltaY.ModSub(&minusPoints[i].y, &startPointY);
+    // Lanes refer to this block's keys, so a partial batch is hashed before the next gather.
+    if (!flushHashBatch()) break;
+    const uint64_t hashed = stages.ticks[STAGE_HASH].load(memory_order_relaxed) - hashedBefore;
+    stages.Add(STAGE_WINDOW, __rdtsc() - inverted - hashed);
+  }
+  savePosition();
+}
+
+// Searches chunks until none are left, its own first and then stolen ones.
+void worker(Secp256K1* secp, int bit_length, int threadId) {
+  SearchScratch scratch(1 + RADIUS_PLUS + RADIUS);
+  RankRange chunk;
+  while (!stop_event.load() && SCHEDULER.Next(threadId, chunk)) {
+    searchRange(secp, bit_length, threadId, chunk, scratch);
+  }
+
+  if (g_smart_logger) {
+    g_smart_logger->logAlgorithmStep("WORKER_END",
+                                     "Thread " + std::to_string(threadId) + " finished");
+  }
+  finished_workers++;
+}
+
+static bool parseUint128(const string& text, __uint128_t& value) {
+  if (text.empty() || text.length() > 39) return false;
+  value = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') return false;
+    value = value * 10 + (c - '0');
+  }
+  return true;
+}
+
+static bool isHex128(const string& text) {
+  return text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+}
+
+// Parses "0x" followed by at most 32 hex digits.
+static bool parseHex128(const string& text, __uint128_t& value) {
+  if (!isHex128(text) || text.size() > 2 + 32) return false;
+  value = 0;
+  for (size_t i = 2; i < text.size(); i++) {
+    const char c = (char)tolower(text[i]);
+    if (!isxdigit((unsigned char)c)) return false;
+    value = (value << 4) | (uint8_t)(c <= '9' ? c - '0' : c - 'a' + 10);
+  }
+  return true;
+}
+
+// Parses a key, in hex with a "0x" prefix or in decimal.
+static bool parseKey(const string& text, __uint128_t& key) {
+  return isHex128(text) ? parseHex128(text, key) : parseUint128(text, key);
+}
+
+// Parses a set of key bits: a hex mask ("0x7FFF") or a comma-separated list of bit numbers and
+// inclusive ranges ("0-15,20"), every bit below 128.
+static bool parseBitSpec(const string& text, __uint128_t& bits) {
+  bits = 0;
+  if (isHex128(text)) return parseHex128(text, bits);
+  stringstream items(text);
+  string item;
+  while (getline(items, item, ',')) {
+    const size_t dash = item.find('-');
+    __uint128_t first, last;
+    if (!parseUint128(item.substr(0, dash), first)) return false;
+    last = first;
+    if (dash != string::npos && !parseUint128(item.substr(dash + 1), last)) return false;
+    if (first > last || last >= 128) return false;
+    for (int bit = (int)first; bit <= (int)last; bit++) bits |= (__uint128_t)1 << bit;
+  }
+  return !text.empty() && text.back() != ',';
+}
+
+// A 128-bit value in hex, e.g. the bit mask 0x7FFF.
+static string hex128(__uint128_t value) {
+  char text[2 + 32 + 1];
+  snprintf(text, sizeof(text), "0x%llX%016llX", (unsigned long long)(value >> 64),
+           (unsigned long long)value);
+  const char* digits = text + 2;
+  while (*digits == '0' && digits[1] != '\0') digits++;
+  return string("0x") + digits;
+}
+
+// The flip count, or the MIN..MAX range of them.
+static string flipCounts() {
+  if (FLIPS_MIN == FLIPS_MAX) return to_string(FLIPS_MIN);
+  return to_string(FLIPS_MIN) + ".." + to_string(FLIPS_MAX);
+}
 
-      Int slope;
-      slope.ModMulK1(&deltaY, &deltaX[i]);
+// Everything that decides which key a rank stands for; workers only join a coordinator with
+// the same configuration.
+static string searchConfig() {
+  // Only a restricted bit set or key range is recorded.
+  const __uint128_t flippable = lowBits(PUZZLE_NUM) & ~lowBits(SWEEP_BITS);
+  const __uint128_t mutableBits = flippable & MUTABLE_BITS & ~FIXED_BITS;
+  const bool puzzleRange =
+      KEY_MIN == (__uint128_t)1 << (PUZZLE_NUM - 1) && KEY_MAX == lowBits(PUZZLE_NUM);
+  return "puzzle=" + to_string(PUZZLE_NUM) + " flips=" + flipCounts() +
+         " order=" + (GRAY_ORDER ? "gray" : "lex") + " sweep=" + to_string(SWEEP_BITS) +
+         (mutableBits == flippable ? "" : " bits=" + hex128(mutableBits)) +
+         (puzzleRange ? "" : " keys=" + hex128(KEY_MIN) + ".." + hex128(KEY_MAX)) +
+         " radius=" + to_string(RADIUS) + "+" + to_string(RADIUS_PLUS) +
+         " combinations=" + to_string_128(total_combinations);
+}
 
-      Int slopeSq;
-      slopeSq.ModSquareK1(&slope);
+// A checkpoint only applies to a run with the same configuration and shard.
+static string checkpointConfig() {
+  string config = searchConfig();
+  if (SHARD_COUNT > 1) config += " shard=" + to_string(SHARD_INDEX) + "/" + to_string(SHARD_COUNT);
+  return config;
+}
 
-      pointBatchX[POINTS_BATCH_SIZE + i].Set(&startPointXNeg);
-      pointBatchX[POINTS_BATCH_SIZE + i].ModAdd(&slopeSq);
-      pointBatchX[POINTS_BATCH_SIZE + i].ModSub(&minusPoints[i].x);
+// Replaces path with text by writing path.tmp and renaming it over path, so readers see either
+// the old or the new contents. A durable write also reaches the disk before the rename.
+static bool replaceFile(const string& path, const string& text, bool durable) {
+  const string tempFile = path + ".tmp";
+  FILE* out = fopen(tempFile.c_str(), "w");
+  if (!out) return false;
+  bool ok = fwrite(text.data(), 1, text.size(), out) == text.size() && fflush(out) == 0;
+#ifdef _WIN32
+  ok = ok && (!durable || _commit(_fileno(out)) == 0);
+  ok = (fclose(out) == 0) && ok;
+  ok = ok && MoveFileExA(tempFile.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+  ok = ok && (!durable || fsync(fileno(out)) == 0);
+  ok = (fclose(out) == 0) && ok;
+  ok = ok && rename(tempFile.c_str(), path.c_str()) == 0;
+#endif
+  if (!ok) remove(tempFile.c_str());
+  return ok;
+}
 
-      Int diffX;
-      diffX.Set(&startPointX);
-      diffX.ModSub(&pointBatchX[POINTS_BATCH_SIZE + i]);
-      diffX.ModMulK1(&slope);
+// Writes the ranges still to search to a temporary file, flushes it to disk and renames it over
+// CHECKPOINT_FILE, so a crash at any point leaves a complete checkpoint behind.
+static bool writeCheckpoint(const vector<RankRange>& ranges) {
+  string text = "mutagen-checkpoint 1\nconfig " + checkpointConfig() + "\n";
+  for (const RankRange& range : ranges) {
+    text += "range " + to_string_128(range.start) + " " + to_string_128(range.position) + " " +
+            to_string_128(range.end) + "\n";
+  }
+  return replaceFile(CHECKPOINT_FILE, text, true);
+}
 
-      pointBatchY[POINTS_BATCH_SIZE + i].Set(&startPointY);
-      pointBatchY[POINTS_BATCH_SIZE + i].ModNeg();
-      pointBatchY[POINTS_BATCH_SIZE + i].ModAdd(&diffX);
+// Reads the ranges of a checkpoint written by a run with the current configuration.
+static bool readCheckpoint(vector<RankRange>& ranges, string& error) {
+  ifstream in(CHECKPOINT_FILE);
+  if (!in) {
+    error = "cannot open checkpoint " + CHECKPOINT_FILE;
+    return false;
+  }
+  string line;
+  if (!getline(in, line) || line != "mutagen-checkpoint 1") {
+    error = CHECKPOINT_FILE + " is not a checkpoint";
+    return false;
+  }
+  const string config = checkpointConfig();
+  int lineNumber = 1;
+  while (getline(in, line)) {
+    lineNumber++;
+    istringstream fields(line);
+    string kind;
+    fields >> kind;
+    if (kind == "config") {
+      string saved;
+      getline(fields >> ws, saved);
+      if (saved != config) {
+        error = CHECKPOINT_FILE + " was written for " + saved + ", this run is " + config;
+        return false;
+      }
+    } else if (kind == "range") {
+      string start, position, end;
+      RankRange range;
+      fields >> start >> position >> end;
+      if (!parseUint128(start, range.start) || !parseUint128(position, range.position) ||
+          !parseUint128(end, range.end) || range.start > range.position ||
+          range.position > range.end || range.end > total_combinations) {
+        error = CHECKPOINT_FILE + ":" + to_string(lineNumber) + ": bad range";
+        return false;
+      }
+      ranges.push_back(range);
+    } else if (!kind.empty()) {
+      error = CHECKPOINT_FILE + ":" + to_string(lineNumber) + ": unknown entry " + kind;
+      return false;
     }
+  }
+  return true;
+}
+
+// A chunk covers about CHUNK_KEYS keys, so the unrank at its start stays negligible while idle
+// threads still find something to steal near the end of the run.
+static __uint128_t chunkCombinations() {
+  const __uint128_t keysPerCombination = 1 + RADIUS_PLUS + RADIUS;
+  return max<__uint128_t>(MIN_CHUNK_COMBINATIONS, CHUNK_KEYS / keysPerCombination);
+}
 
-    int localBatchCount = 0;
-    for (int i = 0; i < fullBatchSize && localBatchCount < HASH_BATCH_SIZE; i++) {
-      Point tempPoint;
-      tempPoint.x.Set(&pointBatchX[i]);
-      tempPoint.y.Set(&pointBatchY[i]);
+// The ranks of shard SHARD_INDEX. The blocks are interleaved so every shard gets work from all
+// parts of the rank order.
+static vector<RankRange> shardRanges() {
+  if (SHARD_COUNT == 1) return {{0, 0, total_combinations}};
+  const __uint128_t blocks = (__uint128_t)SHARD_COUNT * SHARD_BLOCKS;
+  vector<RankRange> ranges;
+  for (__uint128_t block = SHARD_INDEX; block < blocks; block += SHARD_COUNT) {
+    const __uint128_t start = total_combinations * block / blocks;
+    const __uint128_t end = total_combinations * (block + 1) / blocks;
+    if (start < end) ranges.push_back({start, start, end});
+  }
+  return ranges;
+}
 
-      localPubKeys[localBatchCount][0] = tempPoint.y.IsEven() ? 0x02 : 0x03;
-      for (int j = 0; j < 32; j++) {
-        localPubKeys[localBatchCount][1 + j] = pointBatchX[i].GetByte(31 - j);
+// Splits what is left of the saved ranges into WORKERS shares of (nearly) equal size, so a
+// checkpoint can be resumed with a different thread count, and hands them to SCHEDULER. A
+// share may span several ranges; threads that finish early steal chunks from the others.
+static void assignRemainingRanges(const vector<RankRange>& saved, __uint128_t& remaining) {
+  remaining = 0;
+  for (const RankRange& range : saved) remaining += range.end - range.position;
+
+  // Every segment is split between all threads on its own, and threads take their own ranges in
+  // order, so they all work through the cheapest flip counts first.
+  vector<RankRange> ranges;
+  vector<int> owners;
+  for (int segment = 0; segment < (int)SEGMENT_FLIPS.size(); segment++) {
+    vector<RankRange> part;
+    __uint128_t partSize = 0;
+    for (const RankRange& range : saved) {
+      const __uint128_t first = max(range.position, SEGMENT_START[segment]);
+      const __uint128_t last = min(range.end, segmentEnd(segment));
+      if (first < last) {
+        part.push_back({first, first, last});
+        partSize += last - first;
       }
-      pointIndices[localBatchCount] = i;
-      localBatchCount++;
-
-      if (localBatchCount == HASH_BATCH_SIZE) {
-        computeHash160BatchBinSingle(localBatchCount, localPubKeys, localHashResults);
-
-        actual_work_done += HASH_BATCH_SIZE;
-        localComparedCount += HASH_BATCH_SIZE;
-
-        for (int j = 0; j < HASH_BATCH_SIZE; j++) {
-          bool fullMatch = true;
-          for (int k = 0; k < 20; k++) {
-            if (localHashResults[j][k] != TARGET_HASH160_RAW[k]) {
-              fullMatch = false;
-              break;
-            }
-          }
+    }
 
-          if (fullMatch) {
-            auto tEndTime = chrono::high_resolution_clock::now();
-            globalElapsedTime = chrono::duration<double>(tEndTime - tStart).count();
-
-            {
-              lock_guard<mutex> lock(progress_mutex);
-              globalComparedCount += actual_work_done;
-              mkeysPerSec = (double)globalComparedCount / globalElapsedTime / 1e6;
-            }
-
-            Int foundKey;
-            foundKey.Set(&currentKey);
-            int idx = pointIndices[j];
-            if (idx < POINTS_BATCH_SIZE) {
-              Int offset;
-              offset.SetInt32(idx);
-              foundKey.Add(&offset);
-            } else {
-              Int offset;
-              offset.SetInt32(idx - POINTS_BATCH_SIZE);
-              foundKey.Sub(&offset);
-            }
-
-            string hexKey = foundKey.GetBase16();
-            hexKey = string(64 - hexKey.length(), '0') + hexKey;
-
-            // Convert hash to hex for logging
-            std::ostringstream hashHex;
-            hashHex << std::hex << std::setfill('0');
-            for (int k = 0; k < 20; k++) {
-              hashHex << std::setw(2) << (int)localHashResults[j][k];
-            }
-
-            // LOG SOLUTION WITH ANALYSIS
-            if (g_smart_logger) {
-              g_smart_logger->logSolutionAnalysis(hexKey, hashHex.str(), total_checked_avx.load(),
-                                                  flips);
-            }
-
-            {
-              lock_guard<mutex> lock(result_mutex);
-              results.push(make_tuple(hexKey, total_checked_avx.load(), flip_count, flips));
-            }
-            stop_event.store(true);
-            return;
-          }
-        }
+    __uint128_t assigned = 0;
+    int worker = 0;
+    for (const RankRange& range : part) {
+      __uint128_t position = range.position;
+      while (position < range.end) {
+        while (worker + 1 < WORKERS && assigned >= partSize * (worker + 1) / WORKERS) worker++;
+        const __uint128_t shareEnd = partSize * (worker + 1) / WORKERS - assigned;
+        const __uint128_t length = min(range.end - position, max<__uint128_t>(shareEnd, 1));
+        owners.push_back(worker);
+        ranges.push_back({position, position, position + length});
+        position += length;
+        assigned += length;
+      }
+    }
+  }
 
-        total_checked_avx.increment();
-        localBatchCount = 0;
+  SCHEDULER.Init(ranges, owners, WORKERS, chunkCombinations());
+}
 
-        __uint128_t current_total = total_checked_avx.load();
-        if (current_total % REPORT_INTERVAL == 0 || count.load() == end.load() - 1) {
-          auto now = chrono::high_resolution_clock::now();
-          globalElapsedTime = chrono::duration<double>(now - tStart).count();
+// Lowers the calling thread below the search threads, so redrawing the display never takes a
+// core away from them.
+static void lowerThreadPriority() {
+#ifdef _WIN32
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+  // The nice value is per thread on Linux.
+  setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+#endif
+}
 
-          globalComparedCount += localComparedCount;
-          localComparedCount = 0;
-          mkeysPerSec = (double)globalComparedCount / globalElapsedTime / 1e6;
-          double progress = min(100.0, (double)current_total / total_combinations * 100.0);
+// Writes a Prometheus textfile snapshot of this run to METRICS_FILE. threadRates are the
+// keys/s of every thread over the last period; stage times are TSC ticks / ticksPerSecond.
+// segmentLeft holds the combinations left of every flip count, or nothing if unknown.
+static bool writeMetrics(double elapsed, const vector<double>& threadRates,
+                         double ticksPerSecond, const vector<__uint128_t>& segmentLeft) {
+  const uint64_t keysPerCombination = 1 + RADIUS_PLUS + RADIUS;
+  ostringstream text;
+  text << setprecision(15);
+  auto metric = [&](const char* name, const char* type, const char* help) {
+    text << "# HELP mutagen_" << name << " " << help << "\n";
+    text << "# TYPE mutagen_" << name << " " << type << "\n";
+  };
+
+  double rate = 0.0;
+  for (double threadRate : threadRates) rate += threadRate;
+  const uint64_t session = keysThisRun();
+  const __uint128_t checked = CHECKED_BEFORE + session;
+  size_t hits;
+  {
+    lock_guard<mutex> lock(result_mutex);
+    hits = results.size();
+  }
 
-          // LOG PROGRESS
-          if (g_smart_logger) {
-            g_smart_logger->logProgress(globalComparedCount, total_combinations, mkeysPerSec);
-          }
+  metric("keys_per_second", "gauge", "Keys hashed per second over the last refresh.");
+  text << "mutagen_keys_per_second " << rate << "\n";
+  metric("keys_per_second_average", "gauge", "Keys hashed per second over this run.");
+  text << "mutagen_keys_per_second_average " << (elapsed > 0.0 ? session / elapsed : 0.0)
+       << "\n";
+  metric("keys_checked_total", "counter", "Keys checked, resumed runs included.");
+  text << "mutagen_keys_checked_total " << to_string_128(checked) << "\n";
+  metric("keys_total", "gauge", "Keys to check in this search or shard.");
+  text << "mutagen_keys_total " << to_string_128(total_keys) << "\n";
+  metric("combinations_done_total", "counter", "Flip combinations whose whole window is checked.");
+  text << "mutagen_combinations_done_total "
+       << to_string_128((checked + keysSkippedThisRun()) / keysPerCombination)
+       << "\n";
+  metric("combinations_total", "gauge", "Flip combinations in this search or shard.");
+  text << "mutagen_combinations_total " << to_string_128(total_keys / keysPerCombination)
+       << "\n";
+  metric("hits_total", "counter", "Targets found.");
+  text << "mutagen_hits_total " << hits << "\n";
+  metric("elapsed_seconds", "gauge", "Seconds since the search started.");
+  text << "mutagen_elapsed_seconds " << elapsed << "\n";
+  metric("threads", "gauge", "Search threads.");
+  text << "mutagen_threads " << WORKERS << "\n";
+
+  metric("thread_keys_per_second", "gauge", "Keys hashed per second by one thread.");
+  for (int t = 0; t < WORKERS; t++) {
+    text << "mutagen_thread_keys_per_second{thread=\"" << t << "\"} " << threadRates[t] << "\n";
+  }
+  metric("thread_keys_total", "counter", "Keys hashed by one thread in this run.");
+  for (int t = 0; t < WORKERS; t++) {
+    text << "mutagen_thread_keys_total{thread=\"" << t << "\"} "
+         << g_threadCounters[t].keys.load(memory_order_relaxed) << "\n";
+  }
+  if (!segmentLeft.empty()) {
+    metric("flips_combinations_done_total", "counter", "Combinations searched per flip count.");
+    for (size_t segment = 0; segment < segmentLeft.size(); segment++) {
+      text << "mutagen_flips_combinations_done_total{flips=\"" << SEGMENT_FLIPS[segment] << "\"} "
+           << to_string_128(SEGMENT_SHARE[segment] - segmentLeft[segment]) << "\n";
+    }
+    metric("flips_combinations", "gauge", "Combinations per flip count in this search or shard.");
+    for (size_t segment = 0; segment < segmentLeft.size(); segment++) {
+      text << "mutagen_flips_combinations{flips=\"" << SEGMENT_FLIPS[segment] << "\"} "
+           << to_string_128(SEGMENT_SHARE[segment]) << "\n";
+    }
+  }
+  metric("stage_seconds_total", "counter", "Thread time spent in each stage of the search loop.");
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    uint64_t ticks = 0;
+    for (int t = 0; t < WORKERS; t++) {
+      ticks += g_threadStages[t].ticks[stage].load(memory_order_relaxed);
+    }
+    text << "mutagen_stage_seconds_total{stage=\"" << STAGE_NAMES[stage] << "\"} "
+         << (ticksPerSecond > 0.0 ? ticks / ticksPerSecond : 0.0) << "\n";
+  }
+  return replaceFile(METRICS_FILE, text.str(), false);
+}
 
-          lock_guard<mutex> lock(progress_mutex);
-          moveCursorTo(0, 10);
-          cout << "Progress: " << fixed << setprecision(6) << progress << "%\n";
-          cout << "Processed: " << to_string_128(current_total) << "\n";
-          cout << "Speed: " << fixed << setprecision(2) << mkeysPerSec << " Mkeys/s\n";
-          cout << "Elapsed Time: " << formatElapsedTime(globalElapsedTime) << "\n";
-          cout.flush();
-
-          if (current_total >= total_combinations) {
-            stop_event.store(true);
-            break;
-          }
-        }
+// Redraws the progress every REPORT_PERIOD_MS until done is set, and refreshes METRICS_FILE
+// once more after that. It only reads the per-thread counters and key snapshots, so the search
+// threads never touch the terminal. Speeds are shown over the last period and over the whole
+// run; the ETA uses the last period's speed.
+static void reportProgress(const atomic<bool>& done) {
+  lowerThreadPriority();
+  const uint64_t keysPerCombination = 1 + RADIUS_PLUS + RADIUS;
+  vector<uint64_t> previous(WORKERS, 0);
+  vector<double> threadRates(WORKERS, 0.0);
+  auto previousTime = chrono::high_resolution_clock::now();
+  // The TSC rate is measured against the clock over the whole run.
+  const auto clockStart = chrono::steady_clock::now();
+  const uint64_t ticksStart = __rdtsc();
+
+  bool finished = false;
+  while (!finished) {
+    for (int waited = 0; waited < REPORT_PERIOD_MS && !done.load(); waited += 100) {
+      this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    finished = done.load();
+    if (finished && METRICS_FILE.empty()) break;
+
+    const auto now = chrono::high_resolution_clock::now();
+    const double elapsed = chrono::duration<double>(now - tStart).count();
+    const double period = chrono::duration<double>(now - previousTime).count();
+    previousTime = now;
+    uint64_t session = 0;
+    double rate = 0.0;
+    for (int t = 0; t < WORKERS; t++) {
+      const uint64_t keys = g_threadCounters[t].keys.load(memory_order_relaxed);
+      threadRates[t] = (double)(keys - previous[t]) / period / 1e6;
+      rate += threadRates[t];
+      previous[t] = keys;
+      session += keys;
+    }
+    const double average = (double)session / elapsed / 1e6;
+    const __uint128_t checked = CHECKED_BEFORE + session;
+    // Window keys passed over for the key range are done as well.
+    const __uint128_t covered = checked + keysSkippedThisRun();
+    const __uint128_t remaining = covered < total_keys ? total_keys - covered : 0;
+    const double progress = min(100.0, (double)covered / total_keys * 100.0);
+    // Combinations of every flip count still to search in this process's share.
+    const vector<__uint128_t> segmentLeft = SEGMENT_SHARE.empty()
+                                                ? vector<__uint128_t>()
+                                                : segmentCombinations(SCHEDULER.Remaining());
+
+    if (!METRICS_FILE.empty()) {
+      const double clockSeconds =
+          chrono::duration<double>(chrono::steady_clock::now() - clockStart).count();
+      vector<double> keysPerSecond(WORKERS);
+      for (int t = 0; t < WORKERS; t++) keysPerSecond[t] = threadRates[t] * 1e6;
+      writeMetrics(elapsed, keysPerSecond, (__rdtsc() - ticksStart) / clockSeconds, segmentLeft);
+    }
+    if (finished) break;
+
+    if (g_smart_logger) {
+      g_smart_logger->logProgress(session, total_keys, average);
+    }
+
+    // Lines are padded so a shorter value overwrites all of the previous one.
+    auto line = [](const string& text) { cout << left << setw(64) << text << "\n"; };
+    ostringstream text;
+    moveCursorTo(0, 10);
+    text << "Progress: " << fixed << setprecision(6) << progress << "%";
+    line(text.str());
+    line("Processed: " + to_string_128(checked) + " keys");
+    text.str("");
+    text << "Speed: " << fixed << setprecision(2) << rate << " Mkeys/s (average " << average
+         << " Mkeys/s)";
+    line(text.str());
+    line("Elapsed Time: " + formatElapsedTime(elapsed));
+    line("ETA: " + (rate > 0.0 ? formatElapsedTime((double)remaining / (rate * 1e6)) : "unknown") +
+         " for " + to_string_128(remaining / keysPerCombination) + " combinations left");
+    if (segmentLeft.size() > 1) {
+      const int shown = min((int)segmentLeft.size(), MAX_SEGMENTS_SHOWN);
+      for (int segment = 0; segment < shown; segment++) {
+        const __uint128_t share = SEGMENT_SHARE[segment];
+        text.str("");
+        text << "Flips " << SEGMENT_FLIPS[segment] << ": " << fixed << setprecision(2)
+             << (share ? (double)(share - segmentLeft[segment]) / share * 100.0 : 100.0)
+             << "% of " << to_string_128(share) << " combinations";
+        line(text.str());
+      }
+      if ((int)segmentLeft.size() > shown) {
+        line("(" + to_string(segmentLeft.size() - shown) + " more flip counts)");
       }
     }
+    for (int t = 0; t < min(WORKERS, MAX_THREADS_SHOWN); t++) {
+      uint64_t limbs[4];
+      g_threadKeys[t].Read(limbs);
+      text.str("");
+      text << "Thread " << t << ": " << fixed << setprecision(2) << threadRates[t]
+           << " Mkeys/s at " << formatKey(limbs);
+      line(text.str());
+    }
+    if (WORKERS > MAX_THREADS_SHOWN) {
+      line("(" + to_string(WORKERS - MAX_THREADS_SHOWN) + " more threads)");
+    }
+    cout << right;
+    cout.flush();
+  }
+}
+
+// Runs WORKERS threads over the chunks in SCHEDULER, calling tick every 100ms until all of
+// them are done.
+static void runWorkers(Secp256K1* secp, int bit_length, const function<void()>& tick) {
+  finished_workers.store(0);
+  vector<thread> threads;
+  for (int i = 0; i < WORKERS; i++) {
+    threads.emplace_back(worker, secp, bit_length, i);
+  }
+  while (finished_workers.load() < WORKERS) {
+    this_thread::sleep_for(chrono::milliseconds(100));
+    tick();
+  }
+  for (auto& t : threads) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+}
 
-    // --- kluczowa linia: przejdź do następnej kombinacji ---
-    if (!gen.next()) break;
-    count.increment();
+// Everything below this rank of the current lease has been searched.
+static __uint128_t searchedUpTo(const RankRange& lease) {
+  const vector<RankRange> left = SCHEDULER.Remaining();
+  return left.empty() ? lease.end : min(lease.end, left.front().position);
+}
 
-    if (count >= end) {
+// --connect: searches leases from the coordinator until it has none left or stops the search.
+// Hits are passed on within 100ms; progress reports double as the lease heartbeat. Returns
+// true if the coordinator stopped the search.
+static bool runLeases(CoordinatorClient& client, Secp256K1* secp, int bit_length) {
+  const chrono::seconds heartbeat(max(1, client.LeaseTimeout() / 4));
+  const __uint128_t leaseSize = (__uint128_t)WORKERS * LEASE_CHUNKS * chunkCombinations();
+  size_t reportedHits = 0;
+  auto reportHits = [&]() {
+    lock_guard<mutex> lock(result_mutex);
+    auto unreported = results;
+    for (size_t i = 0; i < reportedHits; i++) unreported.pop();
+    for (; !unreported.empty(); unreported.pop()) {
+      client.Hit(get<0>(unreported.front()) + " " + get<4>(unreported.front()));
+    }
+    reportedHits = results.size();
+  };
+
+  uint64_t id;
+  RankRange lease;
+  while (!stop_event.load() && client.Lease(leaseSize, id, lease)) {
+    __uint128_t remaining;
+    assignRemainingRanges({lease}, remaining);
+    auto lastReport = chrono::steady_clock::now();
+    runWorkers(secp, bit_length, [&]() {
+      reportHits();
+      if (client.Stopped()) stop_event.store(true);
+      auto now = chrono::steady_clock::now();
+      if (now - lastReport >= heartbeat) {
+        client.Progress(id, searchedUpTo(lease));
+        lastReport = now;
+      }
+    });
+    reportHits();
+    const __uint128_t searched = searchedUpTo(lease);
+    if (searched < lease.end) {
+      // Stopped early: only the unsearched rest goes back to the pool.
+      client.Progress(id, searched);
       break;
     }
+    client.Complete(id);
   }
+  return client.StopReceived();
+}
 
-  if (!stop_event.load() && total_checked_avx.load() >= total_combinations) {
-    stop_event.store(true);
+// --serve: leases the ranges to worker processes instead of searching them, and keeps the
+// checkpoint the same way a local run does.
+static int runCoordinator(const vector<RankRange>& ranges) {
+  Coordinator coordinator(searchConfig(), ranges, LEASE_TIMEOUT, !CONTINUE_ON_MATCH);
+  string error;
+  if (!coordinator.Listen(SERVE_ADDRESS, error)) {
+    cerr << "Error: " << error << "\n";
+    return 1;
   }
+  cout << "Coordinating on " << SERVE_ADDRESS << " (lease timeout " << LEASE_TIMEOUT << "s)\n";
 
-  if (g_smart_logger) {
-    g_smart_logger->logAlgorithmStep("WORKER_END",
-                                     "Thread " + std::to_string(threadId) + " finished");
+  size_t shownHits = 0;
+  auto showHits = [&]() {
+    for (; shownHits < coordinator.Hits().size(); shownHits++) {
+      cout << "Hit from " << coordinator.Hits()[shownHits] << endl;
+    }
+  };
+  auto lastCheckpoint = chrono::steady_clock::now();
+  auto lastStatus = lastCheckpoint;
+  while (!stop_event.load() && coordinator.Step(100)) {
+    showHits();
+    auto now = chrono::steady_clock::now();
+    if (now - lastStatus >= chrono::seconds(10)) {
+      cout << "Workers: " << coordinator.Workers() << ", leases out: " << coordinator.Leases()
+           << endl;
+      lastStatus = now;
+    }
+    if (CHECKPOINT_INTERVAL > 0 && now - lastCheckpoint >= chrono::seconds(CHECKPOINT_INTERVAL)) {
+      if (!writeCheckpoint(coordinator.Remaining())) {
+        cerr << "Failed to save checkpoint to " << CHECKPOINT_FILE << "\n";
+      }
+      lastCheckpoint = now;
+    }
+  }
+  showHits();
+
+  const vector<RankRange> left = coordinator.Remaining();
+  __uint128_t leftCombinations = 0;
+  for (const RankRange& range : left) leftCombinations += range.end - range.position;
+  if (CHECKPOINT_INTERVAL > 0) {
+    if (!writeCheckpoint(left)) {
+      cerr << "Failed to save checkpoint to " << CHECKPOINT_FILE << "\n";
+    } else if (leftCombinations > 0 && coordinator.Hits().empty()) {
+      cout << "\nProgress saved to " << CHECKPOINT_FILE << " (" << to_string_128(leftCombinations)
+           << " combinations left); continue with --resume\n";
+    }
+  }
+  if (coordinator.Hits().empty() && leftCombinations == 0) {
+    cout << "\nSearch complete, no worker reported a hit\n";
   }
+  return 0;
+}
+
+// "mutagen index INPUT... OUTPUT": builds a target index from targets files. Labels are not
+// kept; hits on an index are reported by their position in it.
+static int runIndexCommand(int argc, char* argv[]) {
+  if (argc < 3) {
+    cerr << "Usage: " << argv[0] << " index TARGETS_FILE... INDEX_FILE\n";
+    return 1;
+  }
+  TargetList list;
+  string error;
+  for (int i = 1; i < argc - 1; i++) {
+    if (!LoadTargetsFile(argv[i], WORKERS, false, list, error)) {
+      cerr << "Error: " << error << "\n";
+      return 1;
+    }
+  }
+  const size_t entries = list.hashes.size() / 20;
+  if (!TargetIndex::Write(argv[argc - 1], list.hashes, error)) {
+    cerr << "Error: " << error << "\n";
+    return 1;
+  }
+  TargetIndex index;
+  if (!index.Open(argv[argc - 1], false, error)) {
+    cerr << "Error: " << error << "\n";
+    return 1;
+  }
+  cout << "Indexed " << index.Size() << " hash160s (" << entries - index.Size()
+       << " duplicates dropped) into " << argv[argc - 1] << "\n";
+  return 0;
 }
 
 void printUsage(const char* programName) {
@@ -802,16 +2282,64 @@ void printUsage(const char* programName) {
   cout << "  -p, --puzzle NUM    Puzzle number to solve (default: 71)\n";
   cout << "  -t, --threads NUM   Number of CPU cores to use (default: all)\n";
   cout << "  -f, --flips NUM     Override default flip count for puzzle\n";
+  cout << "  -m, --flips-min NUM\n";
+  cout << "  -x, --flips-max NUM Search every flip count from MIN to MAX in one run, the counts\n";
+  cout << "                      with the fewest combinations first; a missing bound defaults\n";
+  cout << "                      to the flip count\n";
+  cout << "  -u, --mutable-bits BITS\n";
+  cout << "                      Only flip these key bits, as 0xMASK or ranges like 0-15,20\n";
+  cout << "  -F, --fixed-bits BITS\n";
+  cout << "                      Never flip these key bits\n";
+  cout << "  -n, --key-min KEY\n";
+  cout << "  -N, --key-max KEY   Only search keys in [KEY_MIN, KEY_MAX] (decimal or 0xHEX)\n";
+  cout << "                      within the puzzle interval [2^(NUM-1), 2^NUM), the default;\n";
+  cout << "                      keys outside it are never generated or hashed\n";
+  cout << "  -g, --gray          Enumerate flips in revolving-door (Gray) order and update\n";
+  cout << "                      public keys incrementally instead of recomputing them\n";
+  cout << "  -r, --radius NUM    Keys checked on each side of every mutated key (default: "
+       << POINTS_BATCH_SIZE - 1 << ")\n";
+  cout << "  -s, --sweep         Cover the low log2(window) bits with the window instead of\n";
+  cout << "                      flipping them (each key is tested exactly once)\n";
+  cout << "  -T, --targets FILE  Also search for the targets in FILE, one per line: hex hash160,\n";
+  cout << "                      P2PKH or P2WPKH address, optional label\n";
+  cout << "  -A, --all-puzzles   Also search for the targets of all known puzzles\n";
+  cout << "  -i, --index FILE    Also search for the hash160s in an index built with\n";
+  cout << "                      \"" << programName << " index TARGETS_FILE... INDEX_FILE\"\n";
+  cout << "  -H, --huge-pages    Back the index with huge pages where available\n";
+  cout << "  -c, --continue      Keep searching after a hit and report every hit\n";
+  cout << "  -o, --results FILE  Append every hit to FILE as a JSON line\n";
+  cout << "  -k, --checkpoint FILE\n";
+  cout << "                      Save progress to FILE (default: puzzle_NUM_checkpoint.txt)\n";
+  cout << "  -K, --checkpoint-interval SEC\n";
+  cout << "                      Seconds between checkpoints, 0 disables them (default: "
+       << CHECKPOINT_INTERVAL << ")\n";
+  cout << "  -R, --resume        Continue from the checkpoint, with any thread count\n";
+  cout << "  -S, --shard I/N     Search only shard I of N (0-based); each shard gets an equal,\n";
+  cout << "                      interleaved share of the ranks\n";
+  cout << "  -L, --serve ADDR    Lease the ranks to workers that connect to ADDR instead of\n";
+  cout << "                      searching them (unix:PATH, PORT, HOST:PORT or [IPV6]:PORT,\n";
+  cout << "                      default host 127.0.0.1); a hit stops every worker\n";
+  cout << "  -C, --connect ADDR  Search the ranks leased by the coordinator at ADDR\n";
+  cout << "  -l, --lease-timeout SEC\n";
+  cout << "                      Seconds without progress before a lease is handed out again\n";
+  cout << "                      (default: " << LEASE_TIMEOUT << ")\n";
+  cout << "  -v, --log-level LEVEL\n";
+  cout << "                      Write an algorithm analysis log to " << LOG_FILE << ": off,\n";
+  cout << "                      info or debug (sampled per-combination detail); default off\n";
+  cout << "  -M, --metrics-file FILE\n";
+  cout << "                      Keep a Prometheus textfile snapshot of the search in FILE\n";
+  cout << "                      (rates, combinations, stage timings, hits), refreshed every\n";
+  cout << "                      second by renaming FILE.tmp over it\n";
   cout << "  -h, --help          Show this help message\n";
   cout << "\nExample:\n";
   cout << "  " << programName << " -p 71 -t 12\n";
 }
 
 int main(int argc, char* argv[]) {
-  // INITIALIZE SMART LOGGER
-  g_smart_logger = new SmartMutagenLogger("avx512_log.txt");
-  g_smart_logger->logOperation("PROGRAM_START",
-                               "Mutagen AVX512 Puzzle Solver - Algorithm Analysis Mode");
+  if (argc > 1 && strcmp(argv[1], "index") == 0) {
+    argv[1] = argv[0];
+    return runIndexCommand(argc - 1, argv + 1);
+  }
 
   signal(SIGINT, signalHandler);
 
@@ -820,10 +2348,35 @@ int main(int argc, char* argv[]) {
   static struct option long_options[] = {{"puzzle", required_argument, 0, 'p'},
                                          {"threads", required_argument, 0, 't'},
                                          {"flips", required_argument, 0, 'f'},
+                                         {"flips-min", required_argument, 0, 'm'},
+                                         {"flips-max", required_argument, 0, 'x'},
+                                         {"mutable-bits", required_argument, 0, 'u'},
+                                         {"fixed-bits", required_argument, 0, 'F'},
+                                         {"key-min", required_argument, 0, 'n'},
+                                         {"key-max", required_argument, 0, 'N'},
+                                         {"gray", no_argument, 0, 'g'},
+                                         {"radius", required_argument, 0, 'r'},
+                                         {"sweep", no_argument, 0, 's'},
+                                         {"targets", required_argument, 0, 'T'},
+                                         {"all-puzzles", no_argument, 0, 'A'},
+                                         {"index", required_argument, 0, 'i'},
+                                         {"huge-pages", no_argument, 0, 'H'},
+                                         {"continue", no_argument, 0, 'c'},
+                                         {"results", required_argument, 0, 'o'},
+                                         {"checkpoint", required_argument, 0, 'k'},
+                                         {"checkpoint-interval", required_argument, 0, 'K'},
+                                         {"resume", no_argument, 0, 'R'},
+                                         {"shard", required_argument, 0, 'S'},
+                                         {"serve", required_argument, 0, 'L'},
+                                         {"connect", required_argument, 0, 'C'},
+                                         {"lease-timeout", required_argument, 0, 'l'},
+                                         {"log-level", required_argument, 0, 'v'},
+                                         {"metrics-file", required_argument, 0, 'M'},
                                          {"help", no_argument, 0, 'h'},
                                          {0, 0, 0, 0}};
 
-  while ((opt = getopt_long(argc, argv, "p:t:f:h", long_options, &option_index)) != -1) {
+  while ((opt = getopt_long(argc, argv, "p:t:f:m:x:u:F:n:N:gr:sT:Ai:Hco:k:K:RS:L:C:l:v:M:h",
+                            long_options, &option_index)) != -1) {
     if (opt == -1) break;
     switch (opt) {
       case 'p':
@@ -847,6 +2400,121 @@ int main(int argc, char* argv[]) {
           return 1;
         }
         break;
+      case 'm':
+        FLIPS_MIN = atoi(optarg);
+        if (FLIPS_MIN < 1) {
+          cerr << "Error: Flip count must be at least 1\n";
+          return 1;
+        }
+        break;
+      case 'x':
+        FLIPS_MAX = atoi(optarg);
+        if (FLIPS_MAX < 1) {
+          cerr << "Error: Flip count must be at least 1\n";
+          return 1;
+        }
+        break;
+      case 'u':
+        if (!parseBitSpec(optarg, MUTABLE_BITS)) {
+          cerr << "Error: Invalid bit set '" << optarg << "' (use 0xMASK or ranges like 0-15,20)\n";
+          return 1;
+        }
+        break;
+      case 'F':
+        if (!parseBitSpec(optarg, FIXED_BITS)) {
+          cerr << "Error: Invalid bit set '" << optarg << "' (use 0xMASK or ranges like 0-15,20)\n";
+          return 1;
+        }
+        break;
+      case 'n':
+      case 'N':
+        if (!parseKey(optarg, opt == 'n' ? KEY_MIN : KEY_MAX)) {
+          cerr << "Error: Invalid key '" << optarg << "' (use decimal or 0xHEX)\n";
+          return 1;
+        }
+        break;
+      case 'g':
+        GRAY_ORDER = true;
+        break;
+      case 'r':
+        RADIUS = atoi(optarg);
+        if (RADIUS < 0 || RADIUS > MAX_RADIUS) {
+          cerr << "Error: Radius must be between 0 and " << MAX_RADIUS << "\n";
+          return 1;
+        }
+        break;
+      case 's':
+        SWEEP_MODE = true;
+        break;
+      case 'T':
+        TARGETS_FILE = optarg;
+        break;
+      case 'A':
+        ALL_PUZZLE_TARGETS = true;
+        break;
+      case 'i':
+        INDEX_FILE = optarg;
+        break;
+      case 'H':
+        INDEX_HUGE_PAGES = true;
+        break;
+      case 'c':
+        CONTINUE_ON_MATCH = true;
+        break;
+      case 'o':
+        RESULTS_FILE = optarg;
+        break;
+      case 'k':
+        CHECKPOINT_FILE = optarg;
+        break;
+      case 'K':
+        CHECKPOINT_INTERVAL = atoi(optarg);
+        if (CHECKPOINT_INTERVAL < 0) {
+          cerr << "Error: Checkpoint interval must not be negative\n";
+          return 1;
+        }
+        break;
+      case 'R':
+        RESUME = true;
+        break;
+      case 'S': {
+        char extra;
+        if (sscanf(optarg, "%d/%d%c", &SHARD_INDEX, &SHARD_COUNT, &extra) != 2 ||
+            SHARD_COUNT < 1 || SHARD_COUNT > MAX_SHARDS || SHARD_INDEX < 0 ||
+            SHARD_INDEX >= SHARD_COUNT) {
+          cerr << "Error: Shard must be I/N with 0 <= I < N <= " << MAX_SHARDS << "\n";
+          return 1;
+        }
+        break;
+      }
+      case 'L':
+        SERVE_ADDRESS = optarg;
+        break;
+      case 'C':
+        CONNECT_ADDRESS = optarg;
+        break;
+      case 'l':
+        LEASE_TIMEOUT = atoi(optarg);
+        if (LEASE_TIMEOUT < 1) {
+          cerr << "Error: Lease timeout must be at least 1 second\n";
+          return 1;
+        }
+        break;
+      case 'v':
+        if (strcmp(optarg, "off") == 0) {
+          LOG_LEVEL = LOG_OFF;
+        } else if (strcmp(optarg, "info") == 0) {
+          LOG_LEVEL = LOG_INFO;
+        } else if (strcmp(optarg, "debug") == 0) {
+          LOG_LEVEL = LOG_DEBUG;
+        } else {
+          cerr << "Error: Log level must be off, info or debug\n";
+          return 1;
+        }
+        break;
+      case 'M':
+        METRICS_FILE = optarg;
+        break;
       case 'h':
         printUsage(argv[0]);
         return 0;
@@ -856,6 +2524,21 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  if (!CONNECT_ADDRESS.empty()) {
+    if (!SERVE_ADDRESS.empty() || RESUME || SHARD_COUNT > 1) {
+      cerr << "Error: --connect takes its work from the coordinator; it cannot be combined with "
+              "--serve, --resume or --shard\n";
+      return 1;
+    }
+    // The coordinator keeps track of progress.
+    CHECKPOINT_INTERVAL = 0;
+  }
+
+  if (!verifyHashKernels()) {
+    cerr << "Error: hash kernels do not match the scalar reference\n";
+    return 1;
+  }
+
   tStart = chrono::high_resolution_clock::now();
 
   Secp256K1 secp;
@@ -872,6 +2555,12 @@ int main(int argc, char* argv[]) {
   if (FLIP_COUNT == -1) {
     FLIP_COUNT = DEFAULT_FLIP_COUNT;
   }
+  if (FLIPS_MIN == -1) FLIPS_MIN = FLIPS_MAX == -1 ? FLIP_COUNT : min(FLIP_COUNT, FLIPS_MAX);
+  if (FLIPS_MAX == -1) FLIPS_MAX = max(FLIP_COUNT, FLIPS_MIN);
+  if (FLIPS_MIN > FLIPS_MAX || FLIPS_MAX > PUZZLE_NUM) {
+    cerr << "Error: Flip counts must satisfy 1 <= min <= max <= " << PUZZLE_NUM << "\n";
+    return 1;
+  }
 
   TARGET_HASH160 = TARGET_HASH160_HEX;
 
@@ -879,6 +2568,44 @@ int main(int argc, char* argv[]) {
     TARGET_HASH160_RAW[i] = stoul(TARGET_HASH160.substr(i * 2, 2), nullptr, 16);
   }
 
+  TARGETS.Add(TARGET_HASH160_RAW.data(), "puzzle " + to_string(PUZZLE_NUM));
+  if (ALL_PUZZLE_TARGETS) {
+    for (const auto& [num, data] : PUZZLE_DATA) {
+      TARGETS.AddHex(get<1>(data), "puzzle " + to_string(num));
+    }
+  }
+  if (!TARGETS_FILE.empty()) {
+    TargetList list;
+    string error;
+    if (!LoadTargetsFile(TARGETS_FILE, WORKERS, true, list, error)) {
+      cerr << "Error: " << error << "\n";
+      return 1;
+    }
+    for (size_t i = 0; i < list.labels.size(); i++) {
+      TARGETS.Add(&list.hashes[i * 20], list.labels[i]);
+    }
+  }
+  TARGETS.Build();
+  if (!INDEX_FILE.empty()) {
+    string error;
+    if (!INDEX.Open(INDEX_FILE, INDEX_HUGE_PAGES, error)) {
+      cerr << "Error: " << error << "\n";
+      return 1;
+    }
+  }
+
+  if (!RESULTS_FILE.empty()) {
+    RESULTS_SINK.open(RESULTS_FILE, ios::app);
+    if (!RESULTS_SINK) {
+      cerr << "Error: Cannot open results file " << RESULTS_FILE << "\n";
+      return 1;
+    }
+  }
+  if (!METRICS_FILE.empty() && !replaceFile(METRICS_FILE, "", false)) {
+    cerr << "Error: Cannot write metrics file " << METRICS_FILE << "\n";
+    return 1;
+  }
+
   BASE_KEY.SetBase10(const_cast<char*>(PRIVATE_KEY_DECIMAL.c_str()));
 
   Int testKey;
@@ -893,7 +2620,159 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  total_combinations = CombinationGenerator::combinations_count(PUZZLE_NUM, FLIP_COUNT);
+  int flipPositions = PUZZLE_NUM;
+  int minFlips = FLIPS_MIN;
+  int maxFlips = FLIPS_MAX;
+  FLIP_BASE_KEY.Set(&BASE_KEY);
+  RADIUS_PLUS = RADIUS;
+  if (SWEEP_MODE) {
+    // The window is shrunk to the largest power of two it contains, [center-2^(L-1),
+    // center+2^(L-1)-1], which covers every value of the low L bits once.
+    while ((2 << SWEEP_BITS) <= 2 * RADIUS + 1) SWEEP_BITS++;
+    if (SWEEP_BITS == 0 || SWEEP_BITS >= PUZZLE_NUM) {
+      cerr << "Error: Sweep mode needs a radius of at least 1\n";
+      return 1;
+    }
+    RADIUS = 1 << (SWEEP_BITS - 1);
+    RADIUS_PLUS = RADIUS - 1;
+    FLIP_BASE_KEY.bits64[0] &= ~((1ULL << SWEEP_BITS) - 1);
+    FLIP_BASE_KEY.bits64[0] |= 1ULL << (SWEEP_BITS - 1);
+  }
+  const __uint128_t allowedBits = lowBits(PUZZLE_NUM) & MUTABLE_BITS & ~FIXED_BITS;
+  FLIP_MASK = allowedBits & ~lowBits(SWEEP_BITS);
+  const int mutablePositions = (int)maskPositions(FLIP_MASK).size();
+  if (SWEEP_MODE) {
+    // Any of the flips may fall into the allowed swept bits.
+    const __uint128_t swept = allowedBits & lowBits(SWEEP_BITS);
+    minFlips = max(0, FLIPS_MIN - (int)maskPositions(swept).size());
+    maxFlips = min(FLIPS_MAX, mutablePositions);
+  } else if (maxFlips > mutablePositions) {
+    cerr << "Error: Only " << mutablePositions << " bits may flip, fewer than " << maxFlips
+         << "\n";
+    return 1;
+  }
+
+  const __uint128_t puzzleMin = (__uint128_t)1 << (PUZZLE_NUM - 1);
+  KEY_MIN = max(KEY_MIN, puzzleMin);
+  KEY_MAX = min(KEY_MAX, lowBits(PUZZLE_NUM));
+  if (KEY_MIN > KEY_MAX) {
+    cerr << "Error: Key range lies outside the keys of puzzle " << PUZZLE_NUM << ", "
+         << hex128(puzzleMin) << ".." << hex128(lowBits(PUZZLE_NUM)) << "\n";
+    return 1;
+  }
+  // Bits (from SWEEP_BITS up) in which KEY_MIN and KEY_MAX agree are the same in every key of
+  // the range, so whether they flip is settled up front; the puzzle interval settles the top
+  // bit. The DP only sees the positions left. Neither compares the swept bits, so every block
+  // of swept keys that overlaps the range is searched and the window clips its edge blocks.
+  const __uint128_t baseBits =
+      ((__uint128_t)FLIP_BASE_KEY.bits64[1] << 64) | FLIP_BASE_KEY.bits64[0];
+  const __uint128_t differing = KEY_MIN ^ KEY_MAX;
+  const __uint128_t shared = lowBits(PUZZLE_NUM) & ~lowBits(SWEEP_BITS) &
+                             (differing ? ~lowBits(highestBit(differing) + 1) : ~(__uint128_t)0);
+  const __uint128_t mismatched = (baseBits ^ KEY_MIN) & shared;
+  if (mismatched & ~FLIP_MASK) {
+    cerr << "Error: No key in " << hex128(KEY_MIN) << ".." << hex128(KEY_MAX)
+         << " can be reached: bit " << highestBit(mismatched & ~FLIP_MASK)
+         << " would have to flip but may not\n";
+    return 1;
+  }
+  FORCED_FLIPS = mismatched;
+  FORCED_COUNT = (int)maskPositions(FORCED_FLIPS).size();
+  FLIP_MASK &= ~shared;
+  FLIP_BITS = maskPositions(FLIP_MASK);
+  flipPositions = (int)FLIP_BITS.size();
+  KEY_RANGE.init(baseBits ^ FORCED_FLIPS, FLIP_MASK, KEY_MIN, KEY_MAX, SWEEP_BITS,
+                 PUZZLE_NUM - 1);
+
+  // Flip counts with no key in range get no segment.
+  auto segmentCount = [&](int flips) { return KEY_RANGE.count(flips - FORCED_COUNT); };
+  for (int flips = minFlips; flips <= maxFlips; flips++) {
+    const __uint128_t count = segmentCount(flips);
+    if (count == 0) continue;
+    SEGMENT_FLIPS.push_back(flips);
+    if (count != CombinationGenerator::combinations_count(flipPositions, flips - FORCED_COUNT)) {
+      KEY_RANGE_BINDS = true;
+    }
+  }
+  if (SEGMENT_FLIPS.empty()) {
+    cerr << "Error: No combination of " << flipCounts() << " flips gives a key in "
+         << hex128(KEY_MIN) << ".." << hex128(KEY_MAX) << "\n";
+    return 1;
+  }
+  if (KEY_RANGE_BINDS && GRAY_ORDER) {
+    cerr << "Error: Revolving-door order only takes key ranges that fix high bits, like the "
+            "puzzle interval; use lexicographic order for "
+         << hex128(KEY_MIN) << ".." << hex128(KEY_MAX) << "\n";
+    return 1;
+  }
+  stable_sort(SEGMENT_FLIPS.begin(), SEGMENT_FLIPS.end(),
+              [&](int a, int b) { return segmentCount(a) < segmentCount(b); });
+  for (int flips : SEGMENT_FLIPS) {
+    SEGMENT_START.push_back(total_combinations);
+    total_combinations += segmentCount(flips);
+  }
+  // Progress is measured against this process's shard; a worker of a coordinator has no
+  // share of its own and counts towards the whole search.
+  vector<RankRange> savedRanges = shardRanges();
+  __uint128_t shareCombinations = 0;
+  for (const RankRange& range : savedRanges) shareCombinations += range.end - range.start;
+  total_keys = shareCombinations * (1 + RADIUS_PLUS + RADIUS);
+  if (CONNECT_ADDRESS.empty()) SEGMENT_SHARE = segmentCombinations(savedRanges);
+
+  if (CHECKPOINT_FILE.empty()) {
+    CHECKPOINT_FILE = "puzzle_" + to_string(PUZZLE_NUM) + "_checkpoint.txt";
+  }
+  if (RESUME) {
+    savedRanges.clear();
+    string error;
+    if (!readCheckpoint(savedRanges, error)) {
+      cerr << "Error: " << error << "\n";
+      return 1;
+    }
+  }
+  __uint128_t remainingCombinations = shareCombinations;
+  CoordinatorClient client;
+  if (!CONNECT_ADDRESS.empty()) {
+    string error;
+    if (!client.Connect(CONNECT_ADDRESS, searchConfig(), error)) {
+      cerr << "Error: " << error << "\n";
+      return 1;
+    }
+  } else if (SERVE_ADDRESS.empty()) {
+    assignRemainingRanges(savedRanges, remainingCombinations);
+  } else {
+    remainingCombinations = 0;
+    for (const RankRange& range : savedRanges) remainingCombinations += range.end - range.position;
+  }
+  CHECKED_BEFORE = (shareCombinations - remainingCombinations) * (1 + RADIUS_PLUS + RADIUS);
+
+  WINDOW_PLUS_POINTS.resize(RADIUS);
+  WINDOW_MINUS_POINTS.resize(RADIUS);
+  for (int i = 0; i < RADIUS; i++) {
+    Int offset;
+    offset.SetInt32(i + 1);
+    WINDOW_PLUS_POINTS[i] = secp.ComputePublicKey(&offset);
+    WINDOW_MINUS_POINTS[i] = WINDOW_PLUS_POINTS[i];
+    WINDOW_MINUS_POINTS[i].y.ModNeg();
+  }
+
+  if (GRAY_ORDER) {
+    FLIP_IN_POINTS.resize(flipPositions);
+    FLIP_OUT_POINTS.resize(flipPositions);
+    for (int i = 0; i < flipPositions; i++) {
+      const int bit = FLIP_BITS[i];
+      Int power;
+      power.SetInt32(1);
+      power.ShiftL(bit);
+      Point p = secp.ComputePublicKey(&power);
+      Point negP = p;
+      negP.y.ModNeg();
+      // Flipping a 0 bit of the base key adds 2^bit, flipping a 1 bit subtracts it.
+      bool baseBitSet = (BASE_KEY.bits64[bit / 64] >> (bit % 64)) & 1;
+      FLIP_IN_POINTS[i] = baseBitSet ? negP : p;
+      FLIP_OUT_POINTS[i] = baseBitSet ? p : negP;
+    }
+  }
 
   string paddedKey = BASE_KEY.GetBase16();
   size_t firstNonZero = paddedKey.find_first_not_of('0');
@@ -906,18 +2785,26 @@ int main(int argc, char* argv[]) {
 
   paddedKey = "0x" + paddedKey;
 
-  // LOG ALGORITHM SETUP
-  g_smart_logger->logAlgorithmStep("ALGORITHM_SETUP", "Puzzle " + std::to_string(PUZZLE_NUM) +
-                                                          " with " + std::to_string(FLIP_COUNT) +
-                                                          " bit flips");
-  g_smart_logger->logAlgorithmStep(
-      "BASE_KEY", "Starting from key: " + paddedKey + " (decimal: " + PRIVATE_KEY_DECIMAL + ")");
-  g_smart_logger->logAlgorithmStep("TARGET", "Looking for hash160: " + TARGET_HASH160);
-  g_smart_logger->logAlgorithmStep(
-      "COMBINATIONS", "Total combinations to test: " + to_string_128(total_combinations));
-  g_smart_logger->logAlgorithmStep("MUTATION_STRATEGY",
-                                   "Will flip " + std::to_string(FLIP_COUNT) + " bits out of " +
-                                       std::to_string(PUZZLE_NUM) + " available bit positions");
+  // INITIALIZE SMART LOGGER AND LOG ALGORITHM SETUP
+  if (LOG_LEVEL != LOG_OFF) {
+    g_smart_logger = new SmartMutagenLogger(LOG_FILE, LOG_LEVEL);
+    g_smart_logger->logOperation("PROGRAM_START",
+                                 "Mutagen AVX512 Puzzle Solver - Algorithm Analysis Mode");
+    g_smart_logger->logAlgorithmStep("ALGORITHM_SETUP", "Puzzle " + std::to_string(PUZZLE_NUM) +
+                                                            " with " + flipCounts() +
+                                                            " bit flips");
+    g_smart_logger->logAlgorithmStep("BASE_KEY", "Starting from key: " + paddedKey +
+                                                     " (decimal: " + PRIVATE_KEY_DECIMAL + ")");
+    g_smart_logger->logAlgorithmStep("TARGET", "Looking for hash160: " + TARGET_HASH160);
+    g_smart_logger->logAlgorithmStep(
+        "COMBINATIONS", "Total combinations to test: " + to_string_128(total_combinations));
+    g_smart_logger->logAlgorithmStep("MUTATION_STRATEGY",
+                                     "Will flip " + flipCounts() + " bits out of " +
+                                         std::to_string(PUZZLE_NUM) + " available bit positions");
+    g_smart_logger->logAlgorithmStep(
+        "ENUMERATION", GRAY_ORDER ? "Revolving-door order, incremental public keys"
+                                  : "Lexicographic order, public key recomputed per combination");
+  }
 
   clearTerminal();
   cout << "=======================================\n";
@@ -926,52 +2813,126 @@ int main(int argc, char* argv[]) {
   cout << "Starting puzzle: " << PUZZLE_NUM << " (" << PUZZLE_NUM << "-bit)\n";
   cout << "Target HASH160: " << TARGET_HASH160.substr(0, 10) << "..."
        << TARGET_HASH160.substr(TARGET_HASH160.length() - 10) << "\n";
+  if (TARGETS.Size() > 1 || INDEX.Size() > 0) {
+    // The index may hold the in-memory targets too, so the two are not added up.
+    cout << "Targets: " << TARGETS.Size() << " in memory";
+    if (INDEX.Size() > 0) cout << ", " << INDEX.Size() << " in the index";
+    cout << (CONTINUE_ON_MATCH ? " (continue on match)" : "") << "\n";
+  }
+  if (!INDEX_FILE.empty()) {
+    cout << "Index: " << INDEX_FILE << " (" << INDEX.Size() << " hash160s"
+         << (INDEX.UsesHugePages() ? ", huge pages" : "") << ")\n";
+  }
   cout << "Base Key: " << paddedKey << "\n";
-  cout << "Flip count: " << FLIP_COUNT << " ";
-  if (FLIP_COUNT != DEFAULT_FLIP_COUNT) {
-    cout << "(override, default was " << DEFAULT_FLIP_COUNT << ")";
+  if (FLIPS_MIN != FLIPS_MAX) {
+    cout << "Flip counts: " << FLIPS_MIN << ".." << FLIPS_MAX << ", cheapest first (default was "
+         << DEFAULT_FLIP_COUNT << ")\n";
+  } else {
+    cout << "Flip count: " << FLIPS_MIN << " ";
+    if (FLIPS_MIN != DEFAULT_FLIP_COUNT) {
+      cout << "(override, default was " << DEFAULT_FLIP_COUNT << ")";
+    }
+    cout << "\n";
   }
-  cout << "\n";
-  if (PUZZLE_NUM == 71 && FLIP_COUNT == 29) {
+  if (PUZZLE_NUM == 71 && FLIPS_MIN <= 29 && FLIPS_MAX >= 29) {
     cout << "*** WARNING: Flip count is an ESTIMATE for Puzzle 71 and might be incorrect! ***\n";
   }
+  if (mutablePositions + SWEEP_BITS < PUZZLE_NUM) {
+    cout << "Mutable bits: " << mutablePositions << " of " << PUZZLE_NUM - SWEEP_BITS << " ("
+         << hex128(allowedBits & ~lowBits(SWEEP_BITS)) << ")\n";
+  }
+  cout << "Key range: " << hex128(KEY_MIN) << ".." << hex128(KEY_MAX)
+       << " (fixed high bits: " << maskPositions(shared).size() << ", flipped: " << FORCED_COUNT
+       << ")\n";
   cout << "Total Flips: " << to_string_128(total_combinations) << "\n";
+  cout << "Flip order: "
+       << (GRAY_ORDER        ? "revolving-door (incremental)"
+           : KEY_RANGE_BINDS ? "by key, only combinations in the key range"
+                             : "lexicographic")
+       << "\n";
+  if (SWEEP_MODE) {
+    cout << "Sweep: low " << SWEEP_BITS << " bits, " << minFlips << ".." << maxFlips
+         << " flips over the other " << mutablePositions << " bits\n";
+  }
+  cout << "Window: -" << RADIUS << "..+" << RADIUS_PLUS << " (" << 1 + RADIUS_PLUS + RADIUS
+       << " keys per combination, " << to_string_128(total_keys) << " keys total)\n";
+  if (SHARD_COUNT > 1) {
+    cout << "Shard: " << SHARD_INDEX << "/" << SHARD_COUNT << " ("
+         << to_string_128(shareCombinations) << " combinations)\n";
+  }
+  if (RESUME) {
+    cout << "Resumed: " << to_string_128(remainingCombinations) << " combinations left ("
+         << CHECKPOINT_FILE << ")\n";
+  }
+  if (!SERVE_ADDRESS.empty()) {
+    const int status = runCoordinator(savedRanges);
+    delete g_smart_logger;
+    return status;
+  }
+  if (client.Connected()) {
+    cout << "Coordinator: " << CONNECT_ADDRESS << "\n";
+  }
   cout << "Using: " << WORKERS << " threads\n";
   cout << "AVX-512 optimizations: ENABLED\n";
-  cout << "Algorithm analysis log: avx512_log.txt\n";
+  if (g_smart_logger) {
+    cout << "Algorithm analysis log: " << LOG_FILE << " ("
+         << (LOG_LEVEL == LOG_DEBUG ? "debug" : "info") << ")\n";
+  }
   cout << "\n";
 
-  g_threadPrivateKeys.resize(WORKERS, "0");
-  vector<thread> threads;
-
-  AVXCounter total_combinations_avx;
-  total_combinations_avx.store(total_combinations);
-
-  AVXCounter comb_per_thread = AVXCounter::div(total_combinations_avx, WORKERS);
-  uint64_t remainder = AVXCounter::mod(total_combinations_avx, WORKERS);
-
-  for (int i = 0; i < WORKERS; i++) {
-    AVXCounter start, end;
-
-    AVXCounter base = AVXCounter::mul(i, comb_per_thread.load());
-    uint64_t extra = min(static_cast<uint64_t>(i), remainder);
-    start.store(base.load() + extra);
+  g_threadKeys.reset(new KeySnapshot[WORKERS]());
+  g_threadCounters.reset(new KeyCounter[WORKERS]());
+  g_threadStages.reset(new StageTicks[WORKERS]());
+  atomic<bool> reportDone(false);
+  thread reporter(reportProgress, cref(reportDone));
+  bool stoppedByCoordinator = false;
+  if (client.Connected()) {
+    stoppedByCoordinator = runLeases(client, &secp, flipPositions);
+  } else {
+    auto lastCheckpoint = chrono::steady_clock::now();
+    runWorkers(&secp, flipPositions, [&]() {
+      auto now = chrono::steady_clock::now();
+      if (CHECKPOINT_INTERVAL > 0 &&
+          now - lastCheckpoint >= chrono::seconds(CHECKPOINT_INTERVAL)) {
+        if (!writeCheckpoint(SCHEDULER.Remaining())) {
+          cerr << "Failed to save checkpoint to " << CHECKPOINT_FILE << "\n";
+        }
+        lastCheckpoint = now;
+      }
+    });
+  }
+  reportDone.store(true);
+  reporter.join();
+  if (g_smart_logger && interrupted.load()) {
+    g_smart_logger->logOperation("INTERRUPT", "Signal received");
+  }
 
-    end.store(start.load() + comb_per_thread.load() + (i < remainder ? 1 : 0));
-    threads.emplace_back(worker, &secp, PUZZLE_NUM, FLIP_COUNT, i, start, end);
+  if (g_smart_logger) {
+    g_smart_logger->logAlgorithmStep("SCHEDULER",
+                                     std::to_string(SCHEDULER.Steals()) + " chunks stolen");
   }
 
-  for (auto& t : threads) {
-    if (t.joinable()) {
-      t.join();
+  const vector<RankRange> left = SCHEDULER.Remaining();
+  __uint128_t leftCombinations = 0;
+  for (const RankRange& range : left) leftCombinations += range.end - range.position;
+  if (CHECKPOINT_INTERVAL > 0) {
+    if (!writeCheckpoint(left)) {
+      cerr << "Failed to save checkpoint to " << CHECKPOINT_FILE << "\n";
+    } else if (leftCombinations > 0 && results.empty()) {
+      cout << "\nProgress saved to " << CHECKPOINT_FILE << " (" << to_string_128(leftCombinations)
+           << " combinations left); continue with --resume\n";
     }
   }
 
   if (!results.empty()) {
-    auto [hex_key, checked, flips, solution_flips] = results.front();
+    auto [hex_key, checked, flips, solution_flips, label] = results.front();
+    results.pop();
+    // Only a hit on the puzzle's own target goes into its solution file.
+    const string& puzzleLabel = TARGETS.Get(TARGETS.Find(TARGET_HASH160_RAW.data())).label;
+    string solutionKey = label == puzzleLabel ? hex_key : "";
     globalElapsedTime =
         chrono::duration<double>(chrono::high_resolution_clock::now() - tStart).count();
-    mkeysPerSec = (double)globalComparedCount / globalElapsedTime / 1e6;
+    mkeysPerSec = (double)keysThisRun() / globalElapsedTime / 1e6;
 
     string compactHex = hex_key;
     size_t firstNonZeroCompact = compactHex.find_first_not_of('0');
@@ -987,38 +2948,57 @@ int main(int argc, char* argv[]) {
     cout << "=========== SOLUTION FOUND ============\n";
     cout << "=======================================\n";
     cout << "Private key: " << compactHex << "\n";
-    cout << "Checked " << to_string_128(checked) << " combinations\n";
+    if (TARGETS.Size() > 1 || INDEX.Size() > 0) cout << "Target: " << label << "\n";
+    cout << "Checked " << to_string_128(checked) << " keys\n";
     cout << "Bit flips: " << flips << endl;
     cout << "Time: " << fixed << setprecision(2) << globalElapsedTime << " seconds ("
          << formatElapsedTime(globalElapsedTime) << ")\n";
     cout << "Speed: " << fixed << setprecision(2) << mkeysPerSec << " Mkeys/s\n";
 
-    ofstream out("puzzle_" + to_string(PUZZLE_NUM) + "_solution.txt");
-    if (out) {
-      out << hex_key;
-      out.close();
-      cout << "Solution saved to puzzle_" << PUZZLE_NUM << "_solution.txt\n";
-    } else {
-      cerr << "Failed to save solution to file!\n";
+    if (!results.empty()) {
+      cout << "Further hits: " << results.size() << "\n";
+      for (int shown = 0; !results.empty(); shown++) {
+        if (shown < 10) {
+          cout << "  " << get<0>(results.front()) << " (" << get<4>(results.front()) << ")\n";
+        }
+        if (get<4>(results.front()) == puzzleLabel) solutionKey = get<0>(results.front());
+        results.pop();
+      }
+    }
+    if (!RESULTS_FILE.empty()) cout << "Hits written to " << RESULTS_FILE << "\n";
+
+    if (!solutionKey.empty()) {
+      ofstream out("puzzle_" + to_string(PUZZLE_NUM) + "_solution.txt");
+      if (out) {
+        out << solutionKey;
+        out.close();
+        cout << "Solution saved to puzzle_" << PUZZLE_NUM << "_solution.txt\n";
+      } else {
+        cerr << "Failed to save solution to file!\n";
+      }
     }
   } else {
-    __uint128_t final_count = total_checked_avx.load();
+    __uint128_t final_count = keysChecked();
     globalElapsedTime =
         chrono::duration<double>(chrono::high_resolution_clock::now() - tStart).count();
 
     if (globalElapsedTime > 1e-6) {
-      mkeysPerSec = (double)globalComparedCount / globalElapsedTime / 1e6;
+      mkeysPerSec = (double)keysThisRun() / globalElapsedTime / 1e6;
     } else {
       mkeysPerSec = 0.0;
     }
-    cout << "\n\nNo solution found. Checked " << to_string_128(final_count) << " combinations\n";
+    if (stoppedByCoordinator) cout << "\n\nThe coordinator stopped the search";
+    cout << "\n\nNo solution found. Checked " << to_string_128(final_count) << " keys\n";
     cout << "Time: " << fixed << setprecision(2) << globalElapsedTime << " seconds ("
          << formatElapsedTime(globalElapsedTime) << ")\n";
     cout << "Speed: " << fixed << setprecision(2) << mkeysPerSec << " Mkeys/s\n";
   }
 
-  g_smart_logger->logAlgorithmStep(
-      "PROGRAM_END", "Analysis complete. Total time: " + std::to_string(globalElapsedTime) + "s");
+  if (g_smart_logger) {
+    g_smart_logger->logAlgorithmStep(
+        "PROGRAM_END",
+        "Analysis complete. Total time: " + std::to_string(globalElapsedTime) + "s");
+  }
   delete g_smart_logger;
   return 0;
 }
@@ -6,10 +6,18 @@
 
 namespace ripemd160avx512 {
 
-// Processes 16 blocks of 32 bytes each.
+// Processes 16 messages of 32 bytes each (the padding block is built internally).
 // Each outputs[i] receives a 20-byte RIPEMD-160 hash for inputs[i].
 void ripemd160avx512_16(const uint8_t* inputs[16], uint8_t* outputs[16]);
 
+// Same on transposed data: message[w] holds little-endian word w of every lane's 32-byte
+// message, hash[w] receives word w of every lane's digest. AVX-512 builds only.
+void ripemd160avx512_16(const __m512i message[8], __m512i hash[5]);
+
+// Scalar RIPEMD-160 of one 32-byte message, byte-identical to ripemd160avx512_16.
+// Used to validate the vector kernel and as the fallback without AVX-512.
+void ripemd160_32(const uint8_t* input, uint8_t* output);
+
 }  // namespace ripemd160avx512
 
 #endif  // RIPEMD160_AVX512_H
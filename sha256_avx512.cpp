@@ -3,6 +3,8 @@
 #include <string.h>
 
 #include "sha256_avx512.h"
+#include "simd_avx512.h"
+#include "transpose_avx512.h"
 
 // SHA-256 constants
 static const uint32_t K[64] = {
@@ -15,111 +17,171 @@ static const uint32_t K[64] = {
     0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
     0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2};
 
-#define ROTR32(x, n) _mm512_ror_epi32(x, n)
-#define SHR32(x, n) _mm512_srli_epi32(x, n)
-#define S0(x) (_mm512_xor_si512(_mm512_xor_si512(ROTR32(x, 2), ROTR32(x, 13)), ROTR32(x, 22)))
-#define S1(x) (_mm512_xor_si512(_mm512_xor_si512(ROTR32(x, 6), ROTR32(x, 11)), ROTR32(x, 25)))
-#define s0(x) (_mm512_xor_si512(_mm512_xor_si512(ROTR32(x, 7), ROTR32(x, 18)), SHR32(x, 3)))
-#define s1(x) (_mm512_xor_si512(_mm512_xor_si512(ROTR32(x, 17), ROTR32(x, 19)), SHR32(x, 10)))
-#define Ch(x, y, z) _mm512_ternarylogic_epi32(z, y, x, 0xCA)
+static const uint32_t H_INIT[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+                                   0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+#define ROTR32(x, n) ror_epi32(x, n)
+#define SHR32(x, n) srli_epi32(x, n)
+#define XOR3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define S0(x) XOR3(ROTR32(x, 2), ROTR32(x, 13), ROTR32(x, 22))
+#define S1(x) XOR3(ROTR32(x, 6), ROTR32(x, 11), ROTR32(x, 25))
+#define s0(x) XOR3(ROTR32(x, 7), ROTR32(x, 18), SHR32(x, 3))
+#define s1(x) XOR3(ROTR32(x, 17), ROTR32(x, 19), SHR32(x, 10))
+#define Ch(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xCA)
 #define Maj(x, y, z) _mm512_ternarylogic_epi32(y, x, z, 0xE8)
+#define ADD(x, y) _mm512_add_epi32(x, y)
 
-void sha256avx512_16B(const uint8_t* inputs[16], uint8_t* outputs[16]) {
-  alignas(64) uint32_t W[64][16];
+// Scalar helpers, also used to fold the constant parts of the 33-byte message schedule.
+static constexpr uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+static constexpr uint32_t sigma0(uint32_t x) { return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3); }
+static constexpr uint32_t sigma1(uint32_t x) { return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10); }
 
-  // Message schedule preparation: load and transpose input blocks
-  for (int blk = 0; blk < 16; ++blk) {
-    for (int t = 0; t < 16; ++t) {
-      // Load 4 bytes as big-endian word
-      W[t][blk] = ((uint32_t)inputs[blk][t * 4 + 0] << 24) |
-                  ((uint32_t)inputs[blk][t * 4 + 1] << 16) |
-                  ((uint32_t)inputs[blk][t * 4 + 2] << 8) | ((uint32_t)inputs[blk][t * 4 + 3]);
-    }
-  }
+// A 33-byte message ends in word 8 (last key byte, 0x80); words 9..14 are zero and word 15 is
+// the bit length.
+static constexpr uint32_t PAD33_LEN = 33 * 8;
+static constexpr uint32_t PAD33_W8 = 0x00800000;
 
-  // Extend the first 16 words into the remaining 48 words
-  for (int t = 16; t < 64; ++t) {
-    for (int blk = 0; blk < 16; ++blk) {
-      uint32_t w15 = W[t - 15][blk];
-      uint32_t w2 = W[t - 2][blk];
-      uint32_t S0v =
-          ((w15 >> 7) | (w15 << (32 - 7))) ^ ((w15 >> 18) | (w15 << (32 - 18))) ^ (w15 >> 3);
-      uint32_t S1v =
-          ((w2 >> 17) | (w2 << (32 - 17))) ^ ((w2 >> 19) | (w2 << (32 - 19))) ^ (w2 >> 10);
-      W[t][blk] = W[t - 16][blk] + S0v + W[t - 7][blk] + S1v;
-    }
-  }
+// Runs the 64 rounds over a fully expanded schedule and adds the initial state.
+static inline void compress(const __m512i W[64], __m512i state[8]) {
+  __m512i a = _mm512_set1_epi32(H_INIT[0]);
+  __m512i b = _mm512_set1_epi32(H_INIT[1]);
+  __m512i c = _mm512_set1_epi32(H_INIT[2]);
+  __m512i d = _mm512_set1_epi32(H_INIT[3]);
+  __m512i e = _mm512_set1_epi32(H_INIT[4]);
+  __m512i f = _mm512_set1_epi32(H_INIT[5]);
+  __m512i g = _mm512_set1_epi32(H_INIT[6]);
+  __m512i h = _mm512_set1_epi32(H_INIT[7]);
 
-  // Initialize hash value for each lane
-  __m512i a = _mm512_set1_epi32(0x6A09E667);
-  __m512i b = _mm512_set1_epi32(0xBB67AE85);
-  __m512i c = _mm512_set1_epi32(0x3C6EF372);
-  __m512i d = _mm512_set1_epi32(0xA54FF53A);
-  __m512i e = _mm512_set1_epi32(0x510E527F);
-  __m512i f = _mm512_set1_epi32(0x9B05688C);
-  __m512i g = _mm512_set1_epi32(0x1F83D9AB);
-  __m512i h = _mm512_set1_epi32(0x5BE0CD19);
-
-  // Load initial state for each lane
-  for (int lane = 0; lane < 16; ++lane) {
-    ((uint32_t*)&a)[lane] = 0x6A09E667;
-    ((uint32_t*)&b)[lane] = 0xBB67AE85;
-    ((uint32_t*)&c)[lane] = 0x3C6EF372;
-    ((uint32_t*)&d)[lane] = 0xA54FF53A;
-    ((uint32_t*)&e)[lane] = 0x510E527F;
-    ((uint32_t*)&f)[lane] = 0x9B05688C;
-    ((uint32_t*)&g)[lane] = 0x1F83D9AB;
-    ((uint32_t*)&h)[lane] = 0x5BE0CD19;
-  }
-
-  // Main compression loop
   for (int t = 0; t < 64; ++t) {
-    // Gather W[t][blk] into one vector (lane 0 = blk 0, lane 15 = blk 15)
-    __m512i Wt = _mm512_set_epi32(W[t][15], W[t][14], W[t][13], W[t][12], W[t][11], W[t][10],
-                                  W[t][9], W[t][8], W[t][7], W[t][6], W[t][5], W[t][4], W[t][3],
-                                  W[t][2], W[t][1], W[t][0]);
-    __m512i Kt = _mm512_set1_epi32(K[t]);
-    __m512i T1 = _mm512_add_epi32(
-        h, _mm512_add_epi32(S1(e), _mm512_add_epi32(Ch(e, f, g), _mm512_add_epi32(Kt, Wt))));
-    __m512i T2 = _mm512_add_epi32(S0(a), Maj(a, b, c));
+    __m512i T1 = ADD(ADD(h, S1(e)), ADD(Ch(e, f, g), ADD(_mm512_set1_epi32(K[t]), W[t])));
+    __m512i T2 = ADD(S0(a), Maj(a, b, c));
     h = g;
     g = f;
     f = e;
-    e = _mm512_add_epi32(d, T1);
+    e = ADD(d, T1);
     d = c;
     c = b;
     b = a;
-    a = _mm512_add_epi32(T1, T2);
+    a = ADD(T1, T2);
   }
 
-  // Add the compressed chunk to the current hash value
-  a = _mm512_add_epi32(a, _mm512_set1_epi32(0x6A09E667));
-  b = _mm512_add_epi32(b, _mm512_set1_epi32(0xBB67AE85));
-  c = _mm512_add_epi32(c, _mm512_set1_epi32(0x3C6EF372));
-  d = _mm512_add_epi32(d, _mm512_set1_epi32(0xA54FF53A));
-  e = _mm512_add_epi32(e, _mm512_set1_epi32(0x510E527F));
-  f = _mm512_add_epi32(f, _mm512_set1_epi32(0x9B05688C));
-  g = _mm512_add_epi32(g, _mm512_set1_epi32(0x1F83D9AB));
-  h = _mm512_add_epi32(h, _mm512_set1_epi32(0x5BE0CD19));
-
-  // Store results lane-wise: outputs[i] = hash for inputs[i]
-  alignas(64) uint32_t result[8][16];
-  _mm512_store_epi32(result[0], a);
-  _mm512_store_epi32(result[1], b);
-  _mm512_store_epi32(result[2], c);
-  _mm512_store_epi32(result[3], d);
-  _mm512_store_epi32(result[4], e);
-  _mm512_store_epi32(result[5], f);
-  _mm512_store_epi32(result[6], g);
-  _mm512_store_epi32(result[7], h);
+  state[0] = ADD(a, _mm512_set1_epi32(H_INIT[0]));
+  state[1] = ADD(b, _mm512_set1_epi32(H_INIT[1]));
+  state[2] = ADD(c, _mm512_set1_epi32(H_INIT[2]));
+  state[3] = ADD(d, _mm512_set1_epi32(H_INIT[3]));
+  state[4] = ADD(e, _mm512_set1_epi32(H_INIT[4]));
+  state[5] = ADD(f, _mm512_set1_epi32(H_INIT[5]));
+  state[6] = ADD(g, _mm512_set1_epi32(H_INIT[6]));
+  state[7] = ADD(h, _mm512_set1_epi32(H_INIT[7]));
+}
 
+// Stores transposed state words as 32-byte big-endian digests, one per lane.
+static inline void storeDigests(const __m512i state[8], uint8_t* outputs[16]) {
+  alignas(64) uint32_t result[8][16];
+  for (int word = 0; word < 8; ++word) {
+    _mm512_store_epi32(result[word], bswap_epi32(state[word]));
+  }
   for (int blk = 0; blk < 16; ++blk) {
     for (int word = 0; word < 8; ++word) {
-      uint32_t w = result[word][blk];
-      outputs[blk][word * 4 + 0] = (w >> 24) & 0xff;
-      outputs[blk][word * 4 + 1] = (w >> 16) & 0xff;
-      outputs[blk][word * 4 + 2] = (w >> 8) & 0xff;
-      outputs[blk][word * 4 + 3] = (w >> 0) & 0xff;
+      memcpy(outputs[blk] + word * 4, &result[word][blk], 4);
     }
   }
 }
+
+void sha256avx512_16B(const uint8_t* inputs[16], uint8_t* outputs[16]) {
+  __m512i W[64];
+  transpose16x8_epi32(inputs, 0, W);
+  transpose16x8_epi32(inputs, 32, W + 8);
+  for (int t = 0; t < 16; ++t) W[t] = bswap_epi32(W[t]);
+
+  for (int t = 16; t < 64; ++t) {
+    W[t] = ADD(ADD(W[t - 16], s0(W[t - 15])), ADD(W[t - 7], s1(W[t - 2])));
+  }
+
+  __m512i state[8];
+  compress(W, state);
+  storeDigests(state, outputs);
+}
+
+void sha256avx512_16_33(const __m512i message[9], __m512i state[8]) {
+  __m512i W[64];
+  for (int t = 0; t < 9; ++t) W[t] = message[t];
+
+  const __m512i zero = _mm512_setzero_si512();
+  for (int t = 9; t < 15; ++t) W[t] = zero;
+  W[15] = _mm512_set1_epi32(PAD33_LEN);
+
+  // Schedule words 16..31 with the terms of the zero words 9..14 dropped and those of the
+  // length word folded into constants.
+  W[16] = ADD(W[0], s0(W[1]));
+  W[17] = ADD(ADD(W[1], s0(W[2])), _mm512_set1_epi32(sigma1(PAD33_LEN)));
+  for (int t = 18; t < 22; ++t) W[t] = ADD(ADD(W[t - 16], s0(W[t - 15])), s1(W[t - 2]));
+  W[22] = ADD(ADD(W[6], s0(W[7])), ADD(s1(W[20]), _mm512_set1_epi32(PAD33_LEN)));
+  W[23] = ADD(ADD(W[7], s0(W[8])), ADD(W[16], s1(W[21])));
+  W[24] = ADD(W[8], ADD(W[17], s1(W[22])));
+  for (int t = 25; t < 30; ++t) W[t] = ADD(W[t - 7], s1(W[t - 2]));
+  W[30] = ADD(ADD(W[23], s1(W[28])), _mm512_set1_epi32(sigma0(PAD33_LEN)));
+  W[31] = ADD(ADD(W[24], s1(W[29])), ADD(s0(W[16]), _mm512_set1_epi32(PAD33_LEN)));
+
+  for (int t = 32; t < 64; ++t) {
+    W[t] = ADD(ADD(W[t - 16], s0(W[t - 15])), ADD(W[t - 7], s1(W[t - 2])));
+  }
+
+  compress(W, state);
+}
+
+void sha256avx512_16_33(const uint8_t* pubKeys[16], __m512i state[8]) {
+  __m512i message[9];
+  transpose16x8_epi32(pubKeys, 0, message);
+  for (int t = 0; t < 8; ++t) message[t] = bswap_epi32(message[t]);
+
+  alignas(64) uint32_t lastByte[16];
+  for (int blk = 0; blk < 16; ++blk) lastByte[blk] = pubKeys[blk][32];
+  message[8] = _mm512_or_si512(slli_epi32(_mm512_load_epi32(lastByte), 24),
+                               _mm512_set1_epi32(PAD33_W8));
+
+  sha256avx512_16_33(message, state);
+}
+
+void sha256avx512_16_33(const uint8_t* pubKeys[16], uint8_t* outputs[16]) {
+  __m512i state[8];
+  sha256avx512_16_33(pubKeys, state);
+  storeDigests(state, outputs);
+}
+
+void sha256_33(const uint8_t* input, uint8_t* output) {
+  uint32_t W[64];
+  uint8_t block[64] = {0};
+  memcpy(block, input, 33);
+  block[33] = 0x80;
+  block[62] = (PAD33_LEN >> 8) & 0xFF;
+  block[63] = PAD33_LEN & 0xFF;
+  for (int t = 0; t < 16; ++t) {
+    W[t] = ((uint32_t)block[t * 4] << 24) | ((uint32_t)block[t * 4 + 1] << 16) |
+           ((uint32_t)block[t * 4 + 2] << 8) | (uint32_t)block[t * 4 + 3];
+  }
+  for (int t = 16; t < 64; ++t) {
+    W[t] = W[t - 16] + sigma0(W[t - 15]) + W[t - 7] + sigma1(W[t - 2]);
+  }
+
+  uint32_t s[8];
+  memcpy(s, H_INIT, sizeof(s));
+  for (int t = 0; t < 64; ++t) {
+    uint32_t S1v = rotr(s[4], 6) ^ rotr(s[4], 11) ^ rotr(s[4], 25);
+    uint32_t ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+    uint32_t T1 = s[7] + S1v + ch + K[t] + W[t];
+    uint32_t S0v = rotr(s[0], 2) ^ rotr(s[0], 13) ^ rotr(s[0], 22);
+    uint32_t maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+    memmove(s + 1, s, 7 * sizeof(uint32_t));
+    s[4] += T1;
+    s[0] = T1 + S0v + maj;
+  }
+
+  for (int word = 0; word < 8; ++word) {
+    uint32_t w = s[word] + H_INIT[word];
+    output[word * 4 + 0] = (w >> 24) & 0xff;
+    output[word * 4 + 1] = (w >> 16) & 0xff;
+    output[word * 4 + 2] = (w >> 8) & 0xff;
+    output[word * 4 + 3] = (w >> 0) & 0xff;
+  }
+}
@@ -8,4 +8,19 @@
 // Each outputs[i] receives 32-byte hash for inputs[i].
 void sha256avx512_16B(const uint8_t* inputs[16], uint8_t* outputs[16]);
 
+// Processes 16 33-byte compressed public keys; the padding words are constant and folded
+// into the message schedule. Each outputs[i] receives the 32-byte hash of pubKeys[i].
+void sha256avx512_16_33(const uint8_t* pubKeys[16], uint8_t* outputs[16]);
+
+// Same, but leaves the result transposed in registers: state[w] holds word w (native
+// integer, i.e. the big-endian digest word) of every lane.
+void sha256avx512_16_33(const uint8_t* pubKeys[16], __m512i state[8]);
+
+// Same, starting from the transposed big-endian message words 0..8 of the keys (word 8 already
+// carries the 0x80 terminator); words 9..15 are implied.
+void sha256avx512_16_33(const __m512i message[9], __m512i state[8]);
+
+// Scalar SHA-256 of one 33-byte message, used to validate the vector kernels.
+void sha256_33(const uint8_t* input, uint8_t* output);
+
 #endif  // SHA256_AVX512_H
@@ -0,0 +1,53 @@
+#ifndef SIMD_AVX512_H
+#define SIMD_AVX512_H
+
+#include <immintrin.h>
+
+// GCC builds the unmasked forms of these intrinsics on _mm512_undefined_epi32(), which
+// -Wuninitialized reports once they are inlined. The zero-masking forms with every lane selected
+// start from a zero vector instead and compile to the same instructions. Immediate operands must
+// stay constant expressions, so those wrappers are macros.
+#define ror_epi32(x, n) _mm512_maskz_ror_epi32((__mmask16)0xFFFF, x, n)
+#define rol_epi32(x, n) _mm512_maskz_rol_epi32((__mmask16)0xFFFF, x, n)
+#define srli_epi32(x, n) _mm512_maskz_srli_epi32((__mmask16)0xFFFF, x, n)
+#define slli_epi32(x, n) _mm512_maskz_slli_epi32((__mmask16)0xFFFF, x, n)
+
+static inline __m512i rolv_epi32(__m512i x, __m512i n) {
+  return _mm512_maskz_rolv_epi32(0xFFFF, x, n);
+}
+
+static inline __m512i sllv_epi32(__m512i x, __m512i n) {
+  return _mm512_maskz_sllv_epi32(0xFFFF, x, n);
+}
+
+// Shift counts of 64 or more give 0, as with the unmasked form.
+static inline __m512i sllv_epi64(__m512i x, __m512i n) {
+  return _mm512_maskz_sllv_epi64(0xFF, x, n);
+}
+
+static inline __m512i srl_epi32(__m512i x, __m128i n) {
+  return _mm512_maskz_srl_epi32(0xFFFF, x, n);
+}
+
+static inline __m512i unpacklo_epi32(__m512i a, __m512i b) {
+  return _mm512_maskz_unpacklo_epi32(0xFFFF, a, b);
+}
+
+static inline __m512i unpackhi_epi32(__m512i a, __m512i b) {
+  return _mm512_maskz_unpackhi_epi32(0xFFFF, a, b);
+}
+
+static inline __m512i unpacklo_epi64(__m512i a, __m512i b) {
+  return _mm512_maskz_unpacklo_epi64(0xFF, a, b);
+}
+
+static inline __m512i unpackhi_epi64(__m512i a, __m512i b) {
+  return _mm512_maskz_unpackhi_epi64(0xFF, a, b);
+}
+
+// Gathers 32-bit words at base + 4 * index[i].
+static inline __m512i gather_epi32(__m512i index, const void* base) {
+  return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, index, base, 4);
+}
+
+#endif  // SIMD_AVX512_H
@@ -0,0 +1,47 @@
+#ifndef TRANSPOSE_AVX512_H
+#define TRANSPOSE_AVX512_H
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simd_avx512.h"
+
+// Loads 32 bytes at rows[i] + offset for 16 rows and transposes them so that out[w] holds
+// 32-bit word w of every row (lane i = row i). Words are loaded as stored (little-endian).
+// Rows i and i+8 share a register; the 8x8 transpose is done per 256-bit half.
+static inline void transpose16x8_epi32(const uint8_t* const rows[16], size_t offset,
+                                       __m512i out[8]) {
+  __m512i r[8], t[8], u[8];
+  for (int i = 0; i < 8; ++i) {
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(rows[i + 8] + offset));
+    r[i] = _mm512_mask_broadcast_i64x4(_mm512_maskz_loadu_epi64(0x0F, rows[i] + offset), 0xF0,
+                                       hi);
+  }
+  for (int i = 0; i < 8; i += 2) {
+    t[i] = unpacklo_epi32(r[i], r[i + 1]);
+    t[i + 1] = unpackhi_epi32(r[i], r[i + 1]);
+  }
+  for (int i = 0; i < 8; i += 4) {
+    u[i + 0] = unpacklo_epi64(t[i + 0], t[i + 2]);
+    u[i + 1] = unpackhi_epi64(t[i + 0], t[i + 2]);
+    u[i + 2] = unpacklo_epi64(t[i + 1], t[i + 3]);
+    u[i + 3] = unpackhi_epi64(t[i + 1], t[i + 3]);
+  }
+  // u[w] (w < 4) holds words w and w+4 of rows 0-3 and 8-11 in its 128-bit lanes, u[w+4]
+  // the same for rows 4-7 and 12-15.
+  const __m512i lowWords = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+  const __m512i highWords = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+  for (int w = 0; w < 4; ++w) {
+    out[w] = _mm512_permutex2var_epi64(u[w], lowWords, u[w + 4]);
+    out[w + 4] = _mm512_permutex2var_epi64(u[w], highWords, u[w + 4]);
+  }
+}
+
+// Reverses the bytes of every 32-bit lane (big-endian <-> little-endian words).
+static inline __m512i bswap_epi32(__m512i x) {
+  const __m512i mask = _mm512_set4_epi32(0x0C0D0E0F, 0x08090A0B, 0x04050607, 0x00010203);
+  return _mm512_shuffle_epi8(x, mask);
+}
+
+#endif  // TRANSPOSE_AVX512_H